@@ -0,0 +1,134 @@
+#include "AssetLoader.h"
+#include "Download.h"
+#include "ImageDecoder.h"
+#include "PhaseTimer.h"
+#include "Trace.h"
+
+AssetLoader::AssetLoader(TexturePool* pool, JobSystem* jobSystem) : requests(256), recycled(256) {
+	texPool = pool;
+	jobs = jobSystem;
+	wake = SDL_CreateSemaphore(0);
+	stopping = false;
+	thread = std::thread(&AssetLoader::run, this);
+}
+
+AssetLoader::~AssetLoader() {
+	stop();
+	SDL_DestroySemaphore(wake);
+}
+
+void AssetLoader::stop() {
+	if (!thread.joinable()) return;
+	stopping = true;
+	SDL_SemPost(wake);
+	thread.join();
+}
+
+bool AssetLoader::post(AssetRequest request) {
+	if (!requests.push(std::move(request))) {
+		return false;
+	}
+	SDL_SemPost(wake);
+	return true;
+}
+
+bool AssetLoader::poll(AssetResult* result) {
+	return results.pop(result);
+}
+
+void AssetLoader::recycle(PixelBuffer* buffer) {
+	//if the recycle queue is somehow full the buffer stays owned by the pool and is freed with it
+	recycled.push(buffer);
+	SDL_SemPost(wake);
+}
+
+void AssetLoader::run() {
+	setTraceThreadName("asset loader");
+	while (!stopping) {
+		SDL_SemWait(wake);
+
+		PixelBuffer* buffer;
+		while (recycled.pop(&buffer)) {
+			texPool->releaseBuffer(buffer);
+		}
+
+		AssetRequest request;
+		while (!stopping && requests.pop(&request)) {
+			dispatch(request);
+		}
+	}
+}
+
+void AssetLoader::dispatch(const AssetRequest& request) {
+	auto result = std::make_shared<AssetResult>();
+	result->imageId = request.imageId;
+	result->decodeRequested = request.decode;
+	result->ticket = request.ticket;
+	result->traceFlow = request.traceFlow;
+
+	//called off while it sat in the queue, nothing to do
+	std::shared_ptr<AssetTicket> ticket = request.ticket;
+	if (!ticket->wantFile) {
+		result->cancelled = true;
+		results.push(*result);
+		return;
+	}
+
+	//a decode after a plain download of the same image waits for it rather than racing it for the file
+	JobRef previous;
+	auto existing = inFlight.find(request.imageId);
+	if (existing != inFlight.end() && !existing->second->isDone()) {
+		previous = existing->second;
+	}
+
+	std::string url = request.url;
+	std::string filename = request.filename;
+	JobRef download = jobs->run(request.priority, [result, ticket, url, filename]() {
+		if (!ticket->wantFile) {
+			result->cancelled = true;
+			return;
+		}
+		setTraceFlow(result->traceFlow);
+		result->onDisk = downloadFile(filename, url, &ticket->wantFile);
+		result->cancelled = !result->onDisk && !ticket->wantFile;
+		setTraceFlow(0);
+	}, { previous });
+	JobRef last = download;
+	if (request.decode) {
+		last = jobs->run(JOB_PRIORITY_HIGH, [this, result, ticket, filename]() {
+			if (!result->onDisk) return;
+			if (!ticket->wantPixels) {
+				result->cancelled = true;
+				return;
+			}
+			result->pixels = texPool->acquireBuffer();
+			setTraceFlow(result->traceFlow);
+			{
+				PhaseTimer timer(PHASE_DECODE);
+				if (!decodeImage(filename, result->pixels, &ticket->wantPixels)) {
+					texPool->releaseBuffer(result->pixels);
+					result->pixels = nullptr;
+					result->cancelled = !ticket->wantPixels;
+				}
+			}
+			setTraceFlow(0);
+		}, { download });
+	}
+	//hand the result to the UI thread, which does the upload
+	JobRef deliver = jobs->run(JOB_PRIORITY_HIGH, [this, result]() {
+		results.push(*result);
+	}, { last });
+	inFlight[request.imageId] = deliver;
+
+	//forget finished chains now and then
+	if (inFlight.size() > 64) {
+		for (auto it = inFlight.begin(); it != inFlight.end();) {
+			if (it->second->isDone()) {
+				it = inFlight.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include "JobSystem.h"
+#include "LockFreeQueue.h"
+#include "TexturePool.h"
+
+//Lets the UI thread call off a request it no longer needs. Jobs check it before they start, from curl's
+//progress callback and between decoded scanlines. A called off request still produces a result, marked cancelled.
+struct AssetTicket {
+	//someone still needs the file; the download stops when this goes false
+	std::atomic<bool> wantFile{ true };
+	//someone still needs the pixels; the decode stops when this goes false
+	std::atomic<bool> wantPixels{ true };
+	//set when the request asks for a decode, never changes
+	bool decode = false;
+};
+
+//Work for the loader thread: make sure filename holds url, and decode it if asked.
+struct AssetRequest {
+	int imageId = -1;
+	std::string url;
+	std::string filename;
+	bool decode = false;
+	//priority of the download, decodes always run at high priority
+	JobPriority priority = JOB_PRIORITY_NORMAL;
+	std::shared_ptr<AssetTicket> ticket;
+	//trace flow following the request, 0 if it isn't sampled (see Trace.h)
+	Uint64 traceFlow = 0;
+};
+
+//What the loader thread did with an AssetRequest. pixels is set when a decode was asked for and worked.
+struct AssetResult {
+	int imageId = -1;
+	bool onDisk = false;
+	bool decodeRequested = false;
+	//the ticket was called off before the work finished
+	bool cancelled = false;
+	PixelBuffer* pixels = nullptr;
+	std::shared_ptr<AssetTicket> ticket;
+	Uint64 traceFlow = 0;
+};
+
+//Gets game images downloaded and decoded off the UI thread. The UI thread posts requests and polls results
+//through lock-free queues; SDL textures are still only touched by the UI thread. The loader thread turns each
+//request into a download -> decode -> deliver job chain on the job system.
+class AssetLoader
+{
+public:
+	AssetLoader(TexturePool* pool, JobSystem* jobSystem);
+
+	//Stops the loader thread. Requests it hasn't dispatched yet are dropped; jobs already queued still run.
+	void stop();
+
+	//Stops the thread if it's still running. The job system must already be stopped.
+	~AssetLoader();
+
+	//UI thread. Never blocks; returns false if the request queue is full.
+	bool post(AssetRequest request);
+
+	//UI thread. Takes the next finished result, returns false if there is none.
+	bool poll(AssetResult* result);
+
+	//UI thread. Hands a result's buffer back once its pixels have been uploaded.
+	void recycle(PixelBuffer* buffer);
+
+private:
+	void run();
+	void dispatch(const AssetRequest& request);
+
+	TexturePool* texPool;
+	JobSystem* jobs;
+	//last job chain queued per image, so requests for one image never run concurrently. Loader thread only.
+	std::map<int, JobRef> inFlight;
+	SpscQueue<AssetRequest> requests;
+	SpscQueue<PixelBuffer*> recycled;
+	MpscQueue<AssetResult> results;
+	//counts posted requests so the thread can sleep without a lock
+	SDL_sem* wake;
+	std::atomic<bool> stopping;
+	std::thread thread;
+};
@@ -0,0 +1,596 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <json/json.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+#include "AssetLoader.h"
+#include "CacheWindow.h"
+#include "Constants.h"
+#include "GameStore.h"
+#include "ImageDecoder.h"
+#include "ImageRegistry.h"
+#include "JobSystem.h"
+#include "PrefetchPolicy.h"
+#include "RenderEngine.h"
+#include "ScheduleLoader.h"
+#include "ScheduleParser.h"
+
+//Microbenchmarks of the hot paths, built as the GameBarBench project. Every fixture is generated, nothing is
+//fetched: schedules of 15 to 10,000 games shaped like statsapi's, and JPEGs written locally.
+//  parse-*        the schedule parse: jsoncpp DOM (what Game used to do), extractSchedule() plus strings, and the scan alone
+//  merge-feeds    mergeFeeds() of FEED_COUNT feeds making up the fixture
+//  store-insert   GameStore::insertGames(), what building the Games costs
+//  check-cache    one move's PrefetchPolicy update and cache window pass, through checkCacheWindow(), as Main's checkCache() does it
+//  decode-jpeg    decodeImage() of one cut size
+//  upload         TexturePool::uploadTexture() of a decoded cut
+//  text           rasterizing a selected tile's title and description, as RenderEngine's text jobs do, plus the textures
+//  render-scene   RenderEngine::renderScene() with every tile loaded, under SDL's software renderer
+//  jobs           AssetLoader-shaped job chain throughput against worker count
+//Results go to stdout as CSV, one row per benchmark and fixture, so two builds' runs can be diffed; anything
+//else goes to stderr.
+
+struct GameStrings {
+	std::string title, description, imgUrl;
+};
+
+//Builds a schedule response shaped like statsapi's, including the fields GameBar ignores. Each day's games
+//start in order through the afternoon. With imageUrl set every image cut points at it.
+std::string makeSchedule(int days, int gamesPerDay, const std::string& imageUrl = "") {
+	std::ostringstream json;
+	json << "{\"copyright\":\"Copyright 2018 MLB Advanced Media, L.P.\",\"totalItems\":" << days * gamesPerDay
+		<< ",\"totalEvents\":0,\"totalGames\":" << days * gamesPerDay << ",\"totalGamesInProgress\":0,\"dates\":[";
+	int pk = 530000;
+	for (int d = 0; d < days; d++) {
+		char date[16];
+		snprintf(date, sizeof(date), "2018-%02d-%02d", 3 + d / 30, 1 + d % 30);
+		json << (d ? "," : "") << "{\"date\":\"" << date << "\",\"totalItems\":" << gamesPerDay << ",\"games\":[";
+		for (int g = 0; g < gamesPerDay; g++, pk++) {
+			bool doubleHeader = g == gamesPerDay - 1;
+			json << (g ? "," : "") << "{\"gamePk\":" << pk << ",\"link\":\"/api/v1.1/game/" << pk << "/feed/live\","
+				<< "\"gameType\":\"R\",\"season\":\"2018\",\"gameDate\":\"" << date << "T" << (12 + g * 11 / gamesPerDay) << ":05:00Z\",\"officialDate\":\"" << date << "\","
+				<< "\"status\":{\"abstractGameState\":\"Final\",\"codedGameState\":\"F\",\"detailedState\":\"Final\",\"statusCode\":\"F\",\"abstractGameCode\":\"F\"},"
+				<< "\"teams\":{\"away\":{\"leagueRecord\":{\"wins\":40,\"losses\":25,\"pct\":\".615\"},\"score\":" << (g % 7)
+				<< ",\"team\":{\"id\":" << (108 + g) << ",\"name\":\"Away Team " << g << "\",\"link\":\"/api/v1/teams/" << (108 + g) << "\"},"
+				<< "\"isWinner\":false,\"splitSquad\":false,\"seriesNumber\":21},"
+				<< "\"home\":{\"leagueRecord\":{\"wins\":30,\"losses\":35,\"pct\":\".462\"},\"score\":" << (g % 5 + 1)
+				<< ",\"team\":{\"id\":" << (140 - g) << ",\"name\":\"Home Team " << g << "\",\"link\":\"/api/v1/teams/" << (140 - g) << "\"},"
+				<< "\"isWinner\":true,\"splitSquad\":false,\"seriesNumber\":21}},"
+				<< "\"decisions\":{\"winner\":{\"id\":" << (600000 + g) << ",\"fullName\":\"Winning Pitcher\",\"link\":\"/api/v1/people/" << (600000 + g) << "\"},"
+				<< "\"loser\":{\"id\":" << (610000 + g) << ",\"fullName\":\"Losing Pitcher\",\"link\":\"/api/v1/people/" << (610000 + g) << "\"}},"
+				<< "\"venue\":{\"id\":" << (3000 + g) << ",\"name\":\"Ballpark " << g << "\",\"link\":\"/api/v1/venues/" << (3000 + g) << "\"},"
+				<< "\"content\":{\"link\":\"/api/v1/game/" << pk << "/content\",\"editorial\":{\"recap\":{\"mlb\":{"
+				<< "\"type\":\"article\",\"state\":\"A\",\"date\":\"" << date << "T20:30:00-04:00\",\"id\":\"recap-" << pk << "\","
+				<< "\"headline\":\"Team " << g << " rallies \\u00e9 walks off \\\"again\\\"\",\"subhead\":\"Late rally\","
+				<< "\"blurb\":\"A long blurb about the game that GameBar never shows, with a few more words to give it weight.\","
+				<< "\"keywordsAll\":[{\"type\":\"team_id\",\"value\":\"" << (108 + g) << "\"},{\"type\":\"game_pk\",\"value\":\"" << pk << "\"}],"
+				<< "\"media\":{\"type\":\"photo\",\"image\":{\"title\":\"Photo\",\"altText\":null,\"cuts\":[";
+			static const int cutSizes[][2] = { { 2208, 1242 }, { 2048, 1152 }, { 1920, 1080 }, { 1536, 864 }, { 1280, 720 }, { 1024, 576 },
+				{ 960, 540 }, { 768, 432 }, { 640, 360 }, { 480, 270 }, { 320, 180 }, { 215, 121 }, { 124, 70 } };
+			for (int c = 0; c < 13; c++) {
+				json << (c ? "," : "") << "{\"aspectRatio\":\"16:9\",\"width\":" << cutSizes[c][0] << ",\"height\":" << cutSizes[c][1] << ",\"src\":\"";
+				if (imageUrl.empty()) {
+					json << "https://img.mlbstatic.com/mlb-images/image/upload/w_" << cutSizes[c][0] << ",h_" << cutSizes[c][1] << "/mlb/" << pk << ".jpg";
+				}
+				else {
+					json << imageUrl;
+				}
+				json << "\",\"at2x\":\"https://img.mlbstatic.com/2x/" << pk << ".jpg\",\"at3x\":\"https://img.mlbstatic.com/3x/" << pk << ".jpg\"}";
+			}
+			json << "]}}}}}},\"gameNumber\":" << (doubleHeader ? 2 : 1) << ",\"doubleHeader\":\"" << (doubleHeader ? "S" : "N") << "\","
+				<< "\"dayNight\":\"day\",\"scheduledInnings\":9,\"inningBreakLength\":120,\"seriesDescription\":\"Regular Season\"}";
+		}
+		json << "],\"events\":[]}";
+	}
+	json << "]}";
+	return json.str();
+}
+
+//The original Game::Game field extraction over a jsoncpp DOM.
+std::vector<GameStrings> parseWithJsoncpp(const std::string& response) {
+	std::vector<GameStrings> out;
+	std::stringstream stream(response);
+	Json::Value root;
+	stream >> root;
+	for (const Json::Value& json : root["dates"][0]["games"]) {
+		GameStrings game;
+		if (!json["teams"]["home"]["team"]["name"].isString() ||
+			!json["teams"]["away"]["team"]["name"].isString() ||
+			!json["officialDate"].isString()) {
+			game.title = "Unknown";
+		}
+		else {
+			game.title = json["officialDate"].asString() + " " +
+				json["teams"]["away"]["team"]["name"].asString() + " at " +
+				json["teams"]["home"]["team"]["name"].asString();
+			if (json["doubleHeader"].isString() &&
+				json["doubleHeader"].asString() != "N" &&
+				json["gameNumber"].isNumeric()) {
+				game.title += " (Game " + json["gameNumber"].asString() + ")";
+			}
+		}
+		if (json["content"]["editorial"]["recap"]["mlb"]["headline"].isString()) {
+			game.description = json["content"]["editorial"]["recap"]["mlb"]["headline"].asString();
+		}
+		else if (json["teams"]["away"]["score"].isNumeric() &&
+			json["teams"]["home"]["score"].isNumeric() &&
+			json["teams"]["home"]["team"]["name"].isString() &&
+			json["teams"]["away"]["team"]["name"].isString()) {
+			int homeScore = json["teams"]["home"]["score"].asInt();
+			int awayScore = json["teams"]["away"]["score"].asInt();
+			game.description = std::to_string(awayScore) + "-" + std::to_string(homeScore) + " " +
+				(homeScore > awayScore ? json["teams"]["home"]["team"]["name"].asString() : json["teams"]["away"]["team"]["name"].asString());
+		}
+		const Json::Value& cuts = json["content"]["editorial"]["recap"]["mlb"]["media"]["image"]["cuts"];
+		game.imgUrl = defaultLogoUrl;
+		if (cuts.isArray()) {
+			for (Json::ArrayIndex i = 0; i < cuts.size(); i++) {
+				if (cuts[i]["width"].isNumeric() && cuts[i]["width"].asInt() == LARGE_IMAGE_WIDTH &&
+					cuts[i]["height"].isNumeric() && cuts[i]["height"].asInt() == LARGE_IMAGE_HEIGHT) {
+					game.imgUrl = cuts[i]["src"].asString();
+					break;
+				}
+			}
+		}
+		out.push_back(game);
+	}
+	return out;
+}
+
+//extractSchedule() followed by the string building GameStore::addGame does.
+std::vector<GameStrings> parseWithExtractor(const std::string& response) {
+	std::vector<GameStrings> out;
+	ScheduleRecords schedule;
+	if (!extractSchedule(response, &schedule) || schedule.dates.empty()) {
+		return out;
+	}
+	out.reserve(schedule.dates[0].gameCount);
+	for (int i = 0; i < schedule.dates[0].gameCount; i++) {
+		const GameRecord& game = schedule.games[schedule.dates[0].firstGame + i];
+		GameStrings strings;
+		std::string homeName = jsonUnescape(game.homeName);
+		std::string awayName = jsonUnescape(game.awayName);
+		if (!isPresent(game.homeName) || !isPresent(game.awayName) || !isPresent(game.officialDate)) {
+			strings.title = "Unknown";
+		}
+		else {
+			strings.title = jsonUnescape(game.officialDate) + " " + awayName + " at " + homeName;
+			if (isPresent(game.doubleHeader) && game.doubleHeader != "N" && game.hasGameNumber) {
+				strings.title += " (Game " + std::to_string(game.gameNumber) + ")";
+			}
+		}
+		if (isPresent(game.headline)) {
+			strings.description = jsonUnescape(game.headline);
+		}
+		else if (game.hasAwayScore && game.hasHomeScore && isPresent(game.homeName) && isPresent(game.awayName)) {
+			strings.description = std::to_string(game.awayScore) + "-" + std::to_string(game.homeScore) + " " +
+				(game.homeScore > game.awayScore ? homeName : awayName);
+		}
+		strings.imgUrl = defaultLogoUrl;
+		for (int c = game.firstCut; c < game.firstCut + game.cutCount; c++) {
+			if (schedule.cuts[c].width == LARGE_IMAGE_WIDTH && schedule.cuts[c].height == LARGE_IMAGE_HEIGHT) {
+				strings.imgUrl = jsonUnescape(schedule.cuts[c].src);
+				break;
+			}
+		}
+		out.push_back(strings);
+	}
+	return out;
+}
+
+//Wall time of one call over iterations, in microseconds.
+struct Timing {
+	double median = 0;
+	double p90 = 0;
+	double min = 0;
+};
+
+//Times body iterations times. setup, if given, runs untimed before each call.
+Timing measure(std::function<void()> body, int iterations, std::function<void()> setup = nullptr) {
+	std::vector<double> samples;
+	for (int i = 0; i < iterations; i++) {
+		if (setup) setup();
+		auto start = std::chrono::steady_clock::now();
+		body();
+		auto stop = std::chrono::steady_clock::now();
+		samples.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+	}
+	std::sort(samples.begin(), samples.end());
+	Timing timing;
+	timing.median = samples[samples.size() / 2];
+	timing.p90 = samples[samples.size() * 9 / 10];
+	timing.min = samples[0];
+	return timing;
+}
+
+//One CSV row: benchmark,fixture,iterations,median_us,p90_us,min_us
+void report(const char* benchmark, const std::string& fixture, int iterations, const Timing& timing) {
+	printf("%s,%s,%d,%.1f,%.1f,%.1f\n", benchmark, fixture.c_str(), iterations, timing.median, timing.p90, timing.min);
+	fflush(stdout);
+}
+
+//schedule fixtures, in games
+const int FIXTURE_GAMES[] = { 15, 100, 1000, 10000 };
+
+//Fewer runs of the bigger fixtures, enough of every one for a stable median.
+int iterationsFor(int games) {
+	return std::max(5, std::min(2000, 30000 / games));
+}
+
+std::string gamesFixture(int games) {
+	return std::to_string(games) + "-games";
+}
+
+//Benchmarks run are the ones whose name starts with filter; all of them if it is empty.
+bool selected(const std::string& filter, const char* benchmark) {
+	return std::string(benchmark).compare(0, filter.size(), filter) == 0;
+}
+
+bool sameGames(const std::vector<GameStrings>& a, const std::vector<GameStrings>& b) {
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].title != b[i].title || a[i].description != b[i].description || a[i].imgUrl != b[i].imgUrl) return false;
+	}
+	return true;
+}
+
+//Writes a w x h gradient JPEG to path, standing in for a downloaded cut.
+bool writeFixtureImage(const std::string& path, int w, int h) {
+	SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 24, SDL_PIXELFORMAT_RGB24);
+	if (!surface) return false;
+	for (int y = 0; y < h; y++) {
+		Uint8* row = (Uint8*)surface->pixels + y * surface->pitch;
+		for (int x = 0; x < w; x++) {
+			row[x * 3] = (Uint8)(x * 255 / w);
+			row[x * 3 + 1] = (Uint8)(y * 255 / h);
+			row[x * 3 + 2] = (Uint8)((x ^ y) & 0xff);
+		}
+	}
+	bool written = IMG_SaveJPG(surface, path.c_str(), 85) == 0;
+	SDL_FreeSurface(surface);
+	if (!written) {
+		std::cerr << "Can't write " << path << ": " << IMG_GetError() << std::endl;
+	}
+	return written;
+}
+
+std::string fixtureImagePath(int w, int h) {
+	return cacheDir + "/bench_" + std::to_string(w) + "x" + std::to_string(h) + ".jpg";
+}
+
+//Parse benchmarks: jsoncpp DOM vs extractSchedule() with the strings GameStore builds, then the scan alone.
+//Both full paths must produce the same strings.
+int benchParse(const std::string& filter) {
+	for (int games : FIXTURE_GAMES) {
+		std::string response = makeSchedule(1, games);
+		int iterations = iterationsFor(games);
+		if (!sameGames(parseWithJsoncpp(response), parseWithExtractor(response))) {
+			std::cerr << gamesFixture(games) << ": extractor output differs from jsoncpp" << std::endl;
+			return 1;
+		}
+		if (selected(filter, "parse-jsoncpp")) {
+			report("parse-jsoncpp", gamesFixture(games), iterations, measure([&]() { parseWithJsoncpp(response); }, iterations));
+		}
+		if (selected(filter, "parse-extractor")) {
+			report("parse-extractor", gamesFixture(games), iterations, measure([&]() { parseWithExtractor(response); }, iterations));
+		}
+		if (selected(filter, "parse-scan")) {
+			report("parse-scan", gamesFixture(games), iterations, measure([&]() {
+				ScheduleRecords records;
+				extractSchedule(response, &records);
+			}, iterations));
+		}
+	}
+	return 0;
+}
+
+//Merge benchmark: the fixture's games split across every feed, as ScheduleLoader's merge job gets them.
+int benchMerge(const std::string& filter) {
+	if (!selected(filter, "merge-feeds")) return 0;
+	for (int games : FIXTURE_GAMES) {
+		int perFeed = (games + FEED_COUNT - 1) / FEED_COUNT;
+		std::vector<std::string> responses(FEED_COUNT);
+		std::vector<ScheduleRecords> records(FEED_COUNT);
+		std::vector<const ScheduleRecords*> feeds;
+		for (int feed = 0; feed < FEED_COUNT; feed++) {
+			responses[feed] = makeSchedule(1, perFeed);
+			extractSchedule(responses[feed], &records[feed]);
+			feeds.push_back(&records[feed]);
+		}
+		int iterations = iterationsFor(games);
+		report("merge-feeds", gamesFixture(games), iterations, measure([&]() {
+			ScheduleRecords merged;
+			mergeFeeds(feeds, &merged);
+		}, iterations));
+	}
+	return 0;
+}
+
+//Store benchmark: a day's games copied into a fresh GameStore, display strings and image picks included.
+//Tearing the previous store down isn't timed.
+int benchStore(const std::string& filter, ImageRegistry* images) {
+	if (!selected(filter, "store-insert")) return 0;
+	for (int games : FIXTURE_GAMES) {
+		std::string response = makeSchedule(1, games);
+		ScheduleRecords records;
+		extractSchedule(response, &records);
+		std::unique_ptr<GameStore> store;
+		int iterations = iterationsFor(games);
+		report("store-insert", gamesFixture(games), iterations, measure([&]() {
+			store->reserve(games);
+			store->insertGames(0, records.games.data(), (int)records.games.size(), records.cuts);
+		}, iterations, [&]() {
+			store.reset();
+			store.reset(new GameStore(images));
+		}));
+	}
+	return 0;
+}
+
+//Cache window benchmark: one move of a selection sweeping across the day and back at 10 moves a second. The
+//registry's loader is stopped, so requests are only queued: this is the UI thread's share of a move.
+int benchCheckCache(const std::string& filter, TexturePool* pool) {
+	if (!selected(filter, "check-cache")) return 0;
+	for (int games : FIXTURE_GAMES) {
+		JobSystem jobs(1);
+		AssetLoader loader(pool, &jobs);
+		loader.stop();
+		ImageRegistry images(pool, &loader);
+		std::string response = makeSchedule(1, games);
+		ScheduleRecords records;
+		extractSchedule(response, &records);
+		int iterations = 2000;
+		{
+			GameStore store(&images);
+			store.insertGames(0, records.games.data(), (int)records.games.size(), records.cuts);
+			PrefetchPolicy prefetch;
+			IndexRange checked;
+			int selectedIndex = 0;
+			int firstDisplayed = 0;
+			int direction = 1;
+			Uint32 now = 0;
+			report("check-cache", gamesFixture(games), iterations, measure([&]() {
+				if (selectedIndex + direction < 0 || selectedIndex + direction >= games) {
+					direction = -direction;
+				}
+				selectedIndex += direction;
+				firstDisplayed = std::max(0, std::min(selectedIndex - GAMES_ON_SCREEN / 2, games - GAMES_ON_SCREEN));
+				now += 100;
+				prefetch.onMove(direction, now);
+				if (prefetch.update(firstDisplayed, games, now)) {
+					checkCacheWindow(&store, &prefetch, &checked, firstDisplayed);
+				}
+			}, iterations));
+		}
+	}
+	return 0;
+}
+
+//Image benchmarks: decoding the cut sizes tiles use and the full size background, and uploading the result.
+int benchImages(const std::string& filter, TexturePool* pool) {
+	if (!selected(filter, "decode-jpeg") && !selected(filter, "upload")) return 0;
+	const int sizes[][2] = { { SMALL_IMAGE_WIDTH, SMALL_IMAGE_HEIGHT }, { LARGE_IMAGE_WIDTH, LARGE_IMAGE_HEIGHT }, { 640, 360 }, { 1920, 1080 } };
+	for (const auto& size : sizes) {
+		std::string path = fixtureImagePath(size[0], size[1]);
+		std::string fixture = std::to_string(size[0]) + "x" + std::to_string(size[1]);
+		if (!writeFixtureImage(path, size[0], size[1])) return 1;
+		PixelBuffer* buffer = pool->acquireBuffer();
+		int iterations = 200;
+		bool decoded = true;
+		Timing decode = measure([&]() { decoded = decodeImage(path, buffer) && decoded; }, iterations);
+		if (!decoded) {
+			std::cerr << "Can't decode " << path << std::endl;
+			pool->releaseBuffer(buffer);
+			return 1;
+		}
+		if (selected(filter, "decode-jpeg")) {
+			report("decode-jpeg", fixture, iterations, decode);
+		}
+		if (selected(filter, "upload")) {
+			report("upload", fixture, iterations, measure([&]() {
+				pool->releaseTexture(pool->uploadTexture(buffer));
+			}, iterations));
+		}
+		pool->releaseBuffer(buffer);
+	}
+	return 0;
+}
+
+//Text benchmark: a selected tile's title and description rasterized with the engine's fonts and turned into
+//textures, going through the fixture's games so the strings vary.
+int benchText(const std::string& filter, SDL_Renderer* renderer) {
+	if (!selected(filter, "text")) return 0;
+	TTF_Font* large = TTF_OpenFont(fontFile.c_str(), gameFontLargeSize);
+	TTF_Font* small = TTF_OpenFont(fontFile.c_str(), gameFontSmallSize);
+	if (!large || !small) {
+		std::cerr << "Can't open " << fontFile << ": " << TTF_GetError() << std::endl;
+		TTF_CloseFont(large);
+		TTF_CloseFont(small);
+		return 1;
+	}
+	std::vector<GameStrings> strings = parseWithExtractor(makeSchedule(1, 15));
+	size_t next = 0;
+	int iterations = 500;
+	report("text", "title+description", iterations, measure([&]() {
+		const GameStrings& game = strings[next++ % strings.size()];
+		SDL_Surface* top = TTF_RenderText_Blended_Wrapped(large, game.title.c_str(), uiColor, LARGE_IMAGE_WIDTH);
+		SDL_Surface* bottom = TTF_RenderText_Blended_Wrapped(small, game.description.c_str(), uiColor, LARGE_IMAGE_WIDTH);
+		SDL_DestroyTexture(SDL_CreateTextureFromSurface(renderer, top));
+		SDL_DestroyTexture(SDL_CreateTextureFromSurface(renderer, bottom));
+		SDL_FreeSurface(top);
+		SDL_FreeSurface(bottom);
+	}, iterations));
+	TTF_CloseFont(large);
+	TTF_CloseFont(small);
+	return 0;
+}
+
+//Scene benchmark: frames of a fully loaded screen with the selection stepping across it, so the selected tile's
+//text and sharper cut are drawn from the engine's caches. Every cut is one local image, already on disk.
+int benchRender(const std::string& filter, RenderEngine* engine, ImageRegistry* images) {
+	if (!selected(filter, "render-scene")) return 0;
+	const std::string tileUrl = "bench://tile.jpg";
+	int tileId = images->registerImage(tileUrl);
+	bool written = writeFixtureImage(images->getFilename(tileId), 640, 360);
+	images->unregisterImage(tileId);
+	if (!written) return 1;
+	for (int games : FIXTURE_GAMES) {
+		std::string response = makeSchedule(1, games, tileUrl);
+		ScheduleRecords records;
+		extractSchedule(response, &records);
+		GameStore store(images);
+		store.setDisplayScale(engine->getDisplayScale());
+		store.insertGames(0, records.games.data(), (int)records.games.size(), records.cuts);
+		int onScreen = std::min(games, GAMES_ON_SCREEN);
+		for (int i = 0; i < onScreen; i++) {
+			store[i].cache(JOB_PRIORITY_HIGH);
+			store[i].load(JOB_PRIORITY_HIGH);
+		}
+		//until every tile and each one's selected cut and text are in, or 10 s
+		int selectedIndex = 0;
+		int settledFrames = 0;
+		Uint32 deadline = SDL_GetTicks() + 10000;
+		while (settledFrames < onScreen * 4 && (int)(SDL_GetTicks() - deadline) < 0) {
+			images->update();
+			engine->renderScene(0, selectedIndex, &store);
+			bool loaded = true;
+			for (int i = 0; i < onScreen; i++) {
+				loaded = loaded && store[i].getImage(i == selectedIndex) != nullptr;
+			}
+			settledFrames = loaded ? settledFrames + 1 : 0;
+			selectedIndex = (selectedIndex + 1) % onScreen;
+			SDL_Delay(1);
+		}
+		if (settledFrames == 0) {
+			std::cerr << "render-scene: images didn't load" << std::endl;
+			return 1;
+		}
+		int iterations = 300;
+		report("render-scene", gamesFixture(games), iterations, measure([&]() {
+			images->update();
+			engine->renderScene(0, selectedIndex, &store);
+			selectedIndex = (selectedIndex + 1) % onScreen;
+		}, iterations));
+		for (int i = 0; i < store.size(); i++) {
+			store[i].free();
+			store[i].uncache();
+		}
+	}
+	return 0;
+}
+
+//Stands in for decoding one image: a few hundred microseconds of CPU work.
+static unsigned int fakeDecode(unsigned int seed) {
+	unsigned int value = seed;
+	for (int i = 0; i < 200000; i++) {
+		value = value * 1664525u + 1013904223u;
+	}
+	return value;
+}
+
+//Job system benchmark: download -> decode -> deliver chains, the shape AssetLoader queues, at each worker count.
+//Downloads are simulated with a sleep since they mostly wait on the network. Each iteration is one full batch.
+int benchJobs(const std::string& filter) {
+	if (!selected(filter, "jobs")) return 0;
+	const int chains = 400;
+	int cores = (int)std::thread::hardware_concurrency();
+	std::cerr << "jobs: " << chains << " chains per batch, default worker count for this machine " << JobSystem::defaultWorkerCount() << std::endl;
+	for (int workers = 1; workers <= std::max(2, cores * 2); workers *= 2) {
+		int iterations = 5;
+		report("jobs", std::to_string(workers) + "-workers", iterations, measure([&]() {
+			MpscQueue<int> delivered;
+			std::atomic<unsigned int> sink(0);
+			JobSystem jobs(workers);
+			for (int i = 0; i < chains; i++) {
+				JobRef download = jobs.run(JOB_PRIORITY_NORMAL, []() {
+					std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				});
+				JobRef decode = jobs.run(JOB_PRIORITY_HIGH, [&sink, i]() {
+					sink += fakeDecode(i);
+				}, { download });
+				jobs.run(JOB_PRIORITY_HIGH, [&delivered, i]() {
+					delivered.push(i);
+				}, { decode });
+			}
+			int received = 0, item;
+			while (received < chains) {
+				if (delivered.pop(&item)) {
+					received++;
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+		}, iterations));
+	}
+	return 0;
+}
+
+//Usage: GameBarBench [benchmark name prefix], e.g. "parse" or "render-scene". Runs everything by default.
+//Run from the project directory, for the font and arrow images; the cache directory is created if need be.
+int main(int argc, char* argv[]) {
+	std::string filter = argc > 1 ? argv[1] : "";
+	std::error_code error;
+	if (!std::filesystem::create_directories(cacheDir, error) && error) {
+		std::cerr << "mkdir " << cacheDir << " failed" << std::endl;
+	}
+	printf("benchmark,fixture,iterations,median_us,p90_us,min_us\n");
+	int rc = 0;
+	rc |= benchParse(filter);
+	rc |= benchMerge(filter);
+	rc |= benchJobs(filter);
+
+	//the rest need SDL. The software renderer keeps GPU and driver out of the numbers, and the dummy video
+	//driver a desktop compositor; set SDL_VIDEODRIVER to use a real window instead
+	const char* sdlBenchmarks[] = { "store-insert", "check-cache", "decode-jpeg", "upload", "text", "render-scene" };
+	bool needSdl = false;
+	for (const char* benchmark : sdlBenchmarks) {
+		needSdl = needSdl || selected(filter, benchmark);
+	}
+	if (!needSdl) return rc;
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+	if (SDL_Init(SDL_INIT_VIDEO) != 0 || TTF_Init() != 0) {
+		std::cerr << "SDL init failed: " << SDL_GetError() << std::endl;
+		return 1;
+	}
+	IMG_Init(IMG_INIT_JPG);
+	//the engine draws the background, so a first run without one gets a stand-in
+	if (FILE* file = fopen(bgFile.c_str(), "r")) {
+		fclose(file);
+	}
+	else {
+		writeFixtureImage(bgFile, SCREEN_WIDTH, SCREEN_HEIGHT);
+	}
+
+	JobSystem* jobs = new JobSystem();
+	RenderEngine* engine = new RenderEngine(jobs);
+	AssetLoader* loader = new AssetLoader(engine->getTexturePool(), jobs);
+	ImageRegistry* images = new ImageRegistry(engine->getTexturePool(), loader);
+	rc |= benchStore(filter, images);
+	rc |= benchCheckCache(filter, engine->getTexturePool());
+	rc |= benchImages(filter, engine->getTexturePool());
+	rc |= benchText(filter, engine->getRenderer());
+	rc |= benchRender(filter, engine, images);
+
+	//same order as GameBar's cleanup
+	loader->stop();
+	delete jobs;
+	delete loader;
+	delete images;
+	delete engine;
+	IMG_Quit();
+	TTF_Quit();
+	SDL_Quit();
+	return rc;
+}
@@ -0,0 +1,40 @@
+#include "CacheWindow.h"
+#include "Constants.h"
+#include <algorithm>
+
+void checkCacheWindow(GameStore* games, PrefetchPolicy* prefetch, IndexRange* checked, int firstDisplayed) {
+	IndexRange loadWindow = prefetch->getLoadWindow();
+	IndexRange cacheWindow = prefetch->getCacheWindow();
+	//only games in the previous or current window can change state, everything else is already released
+	//(or was warmed, and stays cached until a window passes over it)
+	int first = cacheWindow.first;
+	int last = cacheWindow.last;
+	if (checked->last >= checked->first) {
+		first = std::min(first, checked->first);
+		last = std::max(last, checked->last);
+	}
+	first = std::max(first, 0);
+	last = std::min(last, games->size() - 1);
+	for (int i = first; i <= last; i++) {
+		Game game = (*games)[i];
+		//releasing a game calls off its download or decode if it hasn't finished
+		if (!cacheWindow.contains(i)) {
+			game.free();
+			game.uncache();
+		}
+		else if (!loadWindow.contains(i)) {
+			game.free();
+			game.cache();
+		}
+		else if (i < firstDisplayed || i >= firstDisplayed + GAMES_ON_SCREEN) {
+			game.cache();
+			game.load(JOB_PRIORITY_NORMAL);
+		}
+		else {
+			//on screen, ahead of the neighbours
+			game.cache();
+			game.load(JOB_PRIORITY_HIGH);
+		}
+	}
+	*checked = cacheWindow;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "GameStore.h"
+#include "PrefetchPolicy.h"
+
+//Brings games in line with prefetch's windows: games in the cache window are on disk, games in the load window
+//also have textures, and the rest are released. Only games in the last checked or current cache window can
+//change state, so only those are walked; checked is then set to the current cache window. Games on the screen
+//starting at firstDisplayed are loaded ahead of their neighbours.
+void checkCacheWindow(GameStore* games, PrefetchPolicy* prefetch, IndexRange* checked, int firstDisplayed);
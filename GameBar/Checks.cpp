@@ -0,0 +1,130 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include "AssetLoader.h"
+#include "Constants.h"
+#include "GameStore.h"
+#include "ImageRegistry.h"
+#include "JobSystem.h"
+#include "TexturePool.h"
+
+//Correctness checks, built as the GameBarChecks project. Nothing is fetched: every image is written locally and
+//the software renderer runs on SDL's dummy video driver, so they run on build hosts without a network or display.
+//Each check prints what it saw; the exit code is 1 if any failed.
+//  growth    growing the game store never downloads or decodes an image twice
+
+//Loads a few games, then grows the store by inserting more in front of them several times, loading every game
+//again after each insert as checkCache() would. Moving games around must never drop their images: each image
+//is downloaded and decoded once however many times the columns are reallocated. Returns false on a recount.
+bool checkGrowth(SDL_Renderer* ren) {
+	const int batches = 5;
+	const int perBatch = 4;
+	JobSystem jobs;
+	TexturePool pool(ren);
+	AssetLoader loader(&pool, &jobs);
+	ImageRegistry images(&pool, &loader);
+	//one local image per game, written where the registry looks so the download finds it
+	std::vector<std::string> urls;
+	for (int i = 0; i < batches * perBatch; i++) {
+		urls.push_back("test://growth/" + std::to_string(i) + ".jpg");
+		int id = images.registerImage(urls[i]);
+		std::string path = images.getFilename(id);
+		images.unregisterImage(id);
+		SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 640, 360, 24, SDL_PIXELFORMAT_RGB24);
+		SDL_FillRect(surface, NULL, SDL_MapRGB(surface->format, (Uint8)(i * 40), 80, 160));
+		bool written = IMG_SaveJPG(surface, path.c_str(), 85) == 0;
+		SDL_FreeSurface(surface);
+		if (!written) {
+			std::cout << "Error opening file " << path << "!" << std::endl;
+			return false;
+		}
+	}
+	bool ok = true;
+	{
+		GameStore store(&images);
+		store.reserve(perBatch);
+		for (int batch = 0; batch < batches && ok; batch++) {
+			std::vector<GameRecord> records(perBatch);
+			std::vector<CutRecord> cuts(perBatch);
+			for (int i = 0; i < perBatch; i++) {
+				int n = batch * perBatch + i;
+				records[i].gamePk = 530000 + n;
+				records[i].officialDate = "2018-06-10";
+				records[i].gameDate = "2018-06-10T17:05:00Z";
+				records[i].doubleHeader = "N";
+				records[i].awayName = "Away";
+				records[i].homeName = "Home";
+				records[i].firstCut = i;
+				records[i].cutCount = 1;
+				cuts[i].width = 640;
+				cuts[i].height = 360;
+				cuts[i].src = urls[n];
+			}
+			//in front, so every game loaded so far moves
+			store.insertGames(0, records.data(), perBatch, cuts);
+			for (int i = 0; i < store.size(); i++) {
+				store[i].cache();
+				store[i].load();
+			}
+			bool loaded = false;
+			Uint32 deadline = SDL_GetTicks() + 10000;
+			while (!loaded && (int)(SDL_GetTicks() - deadline) < 0) {
+				images.update();
+				loaded = true;
+				for (int i = 0; i < store.size(); i++) {
+					loaded = loaded && store[i].isLoaded();
+				}
+				SDL_Delay(1);
+			}
+			std::cout << "Growth " << batch << ": " << store.size() << " games, " << images.getDownloadCount() << " downloads, "
+				<< images.getDecodeCount() << " decodes" << std::endl;
+			if (!loaded || images.getDownloadCount() != store.size() || images.getDecodeCount() != store.size()) {
+				std::cout << "Growth check failed: expected one download and one decode per game" << std::endl;
+				ok = false;
+			}
+		}
+	}
+	loader.stop();
+	return ok;
+}
+
+//Usage: GameBarChecks. Run from the GameBar folder; the cache directory is created if need be.
+int main(int, char*[]) {
+	std::error_code error;
+	if (!std::filesystem::create_directories(cacheDir, error) && error) {
+		std::cout << "mkdir " << cacheDir << " failed" << std::endl;
+		return 1;
+	}
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+	SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+		std::cout << "SDL_Init Error: " << SDL_GetError() << std::endl;
+		return 1;
+	}
+	IMG_Init(IMG_INIT_JPG);
+	SDL_Window* win = SDL_CreateWindow("GameBarChecks", 0, 0, 640, 480, SDL_WINDOW_HIDDEN);
+	SDL_Renderer* ren = win ? SDL_CreateRenderer(win, -1, SDL_RENDERER_SOFTWARE) : nullptr;
+	if (ren == nullptr) {
+		std::cout << "SDL_CreateRenderer Error: " << SDL_GetError() << std::endl;
+		SDL_Quit();
+		return 1;
+	}
+
+	int failed = 0;
+	if (!checkGrowth(ren)) failed++;
+	if (failed > 0) {
+		std::cout << failed << " check(s) failed" << std::endl;
+	}
+	else {
+		std::cout << "All checks passed" << std::endl;
+	}
+
+	SDL_DestroyRenderer(ren);
+	SDL_DestroyWindow(win);
+	IMG_Quit();
+	SDL_Quit();
+	return failed ? 1 : 0;
+}
@@ -1,10 +1,15 @@
 #pragma once
 #include <SDL2/SDL.h>
+#include <cstdint>
 #include <string>
 
-//Graphical + file elements
-const std::string cacheDir(".\\cache");
-const std::string bgFile(".\\cache\\background.jpg");
+//Graphical + file elements, relative to the working directory. '/' separates on every platform
+const std::string cacheDir("cache");
+const std::string bgFile("cache/background.jpg");
+//the loaded days as of the last exit, see Snapshot.h
+const std::string snapshotFile("cache/schedule.snapshot");
+//the latest main loop stalls, see Watchdog.h
+const std::string stallLogFile("cache/stalls.log");
 const std::string leftFile("left.png");
 const std::string rightFile("right.png");
 const std::string fontFile("OpenSans-Regular.ttf");
@@ -12,7 +17,26 @@ const SDL_Color uiColor = { 255, 255, 255, 255 };
 const int gameFontSmallSize = 12;
 const int gameFontLargeSize = 14;
 
-const std::string jsonUrl("http://statsapi.mlb.com/api/v1/schedule?hydrate=game(content(editorial(recap))),decisions&date=2018-06-10&sportId=1");
+//Schedule feeds merged into one carousel, by statsapi sportId: MLB, Triple-A, Double-A and international.
+//Every schedule url is fetched once per feed, with "&sportId=" and the feed's id appended (see feedUrl()).
+const int FEED_SPORT_IDS[] = { 1, 11, 12, 51 };
+const int FEED_COUNT = sizeof(FEED_SPORT_IDS) / sizeof(FEED_SPORT_IDS[0]);
+
+//Endpoints. Fetched as they are unless --origin (GAMEBAR_ORIGIN) redirects every fetch, see setOrigin().
+//first phase: a day's bare schedule, enough for titles and scores. The YYYY-MM-DD date is appended
+const std::string scheduleUrl("http://statsapi.mlb.com/api/v1/schedule?date=");
+//second phase: headlines and image cuts, fetched in batches as a comma separated list of gamePks is appended,
+//then every feed's sportId
+const std::string editorialUrl("http://statsapi.mlb.com/api/v1/schedule?hydrate=game(content(editorial(recap)))&gamePks=");
+//live updates, polled: a day's schedule with editorial content, the YYYY-MM-DD date is appended
+const std::string refreshUrl("http://statsapi.mlb.com/api/v1/schedule?hydrate=game(content(editorial(recap)))&date=");
+//live updates, pushed: a server-sent event stream, "from=YYYY-MM-DD&to=YYYY-MM-DD" is appended (see StreamUpdateSource.h).
+//Empty to only poll; --stream overrides it. UpdateServer.cpp serves one locally at http://localhost:8080/events?
+const std::string updateStreamUrl("");
+//the carousel opens on startDate and can page anywhere between the season bounds
+const std::string startDate("2018-06-10");
+const std::string seasonFirstDate("2018-03-29");
+const std::string seasonLastDate("2018-10-28");
 const std::string backgroundUrl("http://mlb.mlb.com/mlb/images/devices/ballpark/1920x1080/1.jpg");
 const std::string defaultLogoUrl("http://mlb.mlb.com/mlb/images/devices/ballpark/1920x1080/3.jpg");
 
@@ -21,15 +45,52 @@ const std::string defaultLogoUrl("http://mlb.mlb.com/mlb/images/devices/ballpark
 const int SCREEN_WIDTH = 1920;
 const int SCREEN_HEIGHT = 1080;
 const int ARROW_TEXTURE_WIDTH = 50;
-const int LARGE_IMAGE_WIDTH = 320;  //used to find JSON entry for game image
-const int LARGE_IMAGE_HEIGHT = 180; //used to find JSON entry for game image
-const int SMALL_IMAGE_WIDTH = 215;
-const int SMALL_IMAGE_HEIGHT = 121;
+const int LARGE_IMAGE_WIDTH = 320;  //selected tile, image cuts are picked to cover it
+const int LARGE_IMAGE_HEIGHT = 180; //selected tile, image cuts are picked to cover it
+const int SMALL_IMAGE_WIDTH = 215;  //unselected tile
+const int SMALL_IMAGE_HEIGHT = 121; //unselected tile
 const int CENTERLINE = 540; //y-value all elements align to
 const int ARROW_WIDTH = 60;
 const int ITEM_DISTANCE_WIDTH = 300;
 const int GAMES_ON_SCREEN = 6;
 
+//Prefetch tuning
+const int PREFETCH_LOAD_MARGIN = 1;		//textures kept either side of the screen when still
+const int PREFETCH_CACHE_MARGIN = 2;	//files kept either side of the screen when still
+const int PREFETCH_MAX_LOAD_AHEAD = 4;
+const int PREFETCH_MAX_CACHE_AHEAD = 12;
+const float PREFETCH_LOAD_LEAD_SECONDS = 0.5f;	//how far ahead of the scroll textures are loaded
+const float PREFETCH_CACHE_LEAD_SECONDS = 2.0f;	//how far ahead of the scroll files are downloaded
+const Uint32 PREFETCH_IDLE_MS = 1500;			//no input for this long starts warming the rest of the day
+const Uint32 PREFETCH_WARM_INTERVAL_MS = 200;	//at most one warming download started per interval
+const int EDITORIAL_BATCH_SIZE = 8;		//games per editorial request
+const int EDITORIAL_MAX_PENDING = 2;	//editorial requests in flight at once
+const int DATE_PAGE_MARGIN = 10;	//the next day is fetched once the selection is this close to the loaded edge
+const int MAX_LOADED_DAYS = 5;		//days held at once, the farthest from the selection is dropped beyond this
+const Uint32 DATE_RETRY_MS = 3000;	//wait after a failed day fetch before trying again
+const Uint32 LIVE_REFRESH_MS = 30000;	//loaded days are polled again this often for scores and headlines, 0 turns it off
+const Uint32 STREAM_BACKOFF_MS = 1000;		//first wait before reconnecting a dropped update stream, doubled per failure
+const Uint32 STREAM_MAX_BACKOFF_MS = 30000;
+const int STREAM_FAILURES_BEFORE_POLLING = 3;	//failed connections in a row before polling takes over
+const long STREAM_IDLE_TIMEOUT_S = 45;		//a stream silent this long (no events or keepalives) is dropped
+const int LIVE_PATCHES_PER_FRAME = 4;	//changed games applied per frame, the rest of a refresh waits for the next
+const Uint32 IMAGE_RETRY_MS = 2000;		//wait before asking again for an image that failed, doubled per failure in a row
+const Uint32 IMAGE_MAX_RETRY_MS = 60000;
+const uintmax_t IMAGE_CACHE_MAX_BYTES = 256 * 1024 * 1024;	//image files kept between runs, the oldest go beyond this
+const Uint32 IMAGE_CACHE_TRIM_MS = 60000;	//the image cache is trimmed back to IMAGE_CACHE_MAX_BYTES this often while running
+const Uint32 FRAME_DELAY_MS = 250;	//wait between frames, --frame-delay overrides it
+const int HEADLESS_FRAMES = 300;	//frames a headless run lasts unless --frames says otherwise
+const int GOLDEN_TOLERANCE = 8;		//per channel difference a captured frame's pixel may have from the golden one
+const double GOLDEN_MAX_DIFFERING = 0.001;	//fraction of pixels allowed past that before the frame fails
+const Uint32 PHASE_WINDOW_MS = 5000;	//phase timings on the HUD cover the last 5 to 10 s
+const int HUD_FONT_SIZE = 16;
+const Uint64 TRACE_RING_EVENTS = 8192;	//spans each thread keeps for the trace, the oldest are overwritten
+const int TRACE_SAMPLE_RATE = 16;	//one in this many image requests is followed through the pipeline, --trace-sample overrides it
+const Uint32 METRICS_EXPORT_MS = 15000;	//a --metrics file is rewritten this often
+const Uint32 STALL_DEADLINE_MS = 1000;	//a frame taking longer is reported as a stall, --stall-ms overrides it
+const int STALL_LOG_ENTRIES = 64;	//stalls kept in the log, the oldest are overwritten
+const int STALL_LOG_LINE = 256;		//bytes per stall log line, longer reports are cut
+
 //Curl FileCallback function
 size_t FileCallback(FILE* f, char* ptr, size_t size, size_t nmemb);
 
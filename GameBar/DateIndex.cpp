@@ -0,0 +1,161 @@
+#include "DateIndex.h"
+#include <algorithm>
+#include <cstdio>
+
+//days_from_civil / civil_from_days from Howard Hinnant's date algorithms, proleptic Gregorian calendar
+static int daysFromCivil(int y, unsigned m, unsigned d) {
+	y -= m <= 2;
+	int era = (y >= 0 ? y : y - 399) / 400;
+	unsigned yoe = (unsigned)(y - era * 400);
+	unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (int)doe - 719468;
+}
+
+int parseDay(std::string_view date) {
+	if (date.size() != 10 || date[4] != '-' || date[7] != '-') return -1;
+	int parts[3] = { 0, 0, 0 };
+	int part = 0;
+	for (size_t i = 0; i < date.size(); i++) {
+		if (date[i] == '-') {
+			part++;
+			continue;
+		}
+		if (date[i] < '0' || date[i] > '9') return -1;
+		parts[part] = parts[part] * 10 + (date[i] - '0');
+	}
+	if (parts[1] < 1 || parts[1] > 12 || parts[2] < 1 || parts[2] > 31) return -1;
+	return daysFromCivil(parts[0], parts[1], parts[2]);
+}
+
+std::string formatDay(int day) {
+	day += 719468;
+	int era = (day >= 0 ? day : day - 146096) / 146097;
+	unsigned doe = (unsigned)(day - era * 146097);
+	unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int y = (int)yoe + era * 400;
+	unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	unsigned mp = (5 * doy + 2) / 153;
+	unsigned d = doy - (153 * mp + 2) / 5 + 1;
+	unsigned m = mp + (mp < 10 ? 3 : -9);
+	y += m <= 2;
+	char text[16];
+	snprintf(text, sizeof(text), "%04d-%02u-%02u", y, m, d);
+	return text;
+}
+
+//reads digits [start, start + count) of text, -1 if any isn't one
+static int readNumber(std::string_view text, size_t start, size_t count) {
+	int value = 0;
+	for (size_t i = start; i < start + count; i++) {
+		if (text[i] < '0' || text[i] > '9') return -1;
+		value = value * 10 + (text[i] - '0');
+	}
+	return value;
+}
+
+int64_t parseTime(std::string_view timestamp) {
+	if (timestamp.size() < 19 || timestamp[10] != 'T' || timestamp[13] != ':' || timestamp[16] != ':') return -1;
+	int day = parseDay(timestamp.substr(0, 10));
+	int hours = readNumber(timestamp, 11, 2);
+	int minutes = readNumber(timestamp, 14, 2);
+	int seconds = readNumber(timestamp, 17, 2);
+	if (day < 0 || hours < 0 || minutes < 0 || seconds < 0) return -1;
+	return (int64_t)day * 86400 + hours * 3600 + minutes * 60 + seconds;
+}
+
+int64_t gameStartTime(const GameRecord& game) {
+	int64_t start = parseTime(game.gameDate);
+	if (start >= 0) return start;
+	int day = parseDay(game.officialDate);
+	return day >= 0 ? (int64_t)day * 86400 : 0;
+}
+
+bool DateIndex::empty() {
+	return counts.empty();
+}
+
+void DateIndex::clear() {
+	counts.clear();
+	starts.clear();
+}
+
+void DateIndex::append(int day, int gameCount) {
+	if (counts.empty()) {
+		firstDay = day;
+	}
+	counts.push_back(gameCount);
+	rebuildStarts();
+}
+
+void DateIndex::prepend(int day, int gameCount) {
+	if (counts.empty()) {
+		append(day, gameCount);
+		return;
+	}
+	firstDay = day;
+	counts.insert(counts.begin(), gameCount);
+	rebuildStarts();
+}
+
+void DateIndex::addGames(int day, int count) {
+	if (!contains(day)) return;
+	counts[day - firstDay] += count;
+	rebuildStarts();
+}
+
+void DateIndex::popFront() {
+	if (counts.empty()) return;
+	counts.erase(counts.begin());
+	firstDay++;
+	rebuildStarts();
+}
+
+void DateIndex::popBack() {
+	if (counts.empty()) return;
+	counts.pop_back();
+	rebuildStarts();
+}
+
+int DateIndex::getFirstDay() {
+	return firstDay;
+}
+
+int DateIndex::getLastDay() {
+	return firstDay + (int)counts.size() - 1;
+}
+
+int DateIndex::getDayCount() {
+	return (int)counts.size();
+}
+
+bool DateIndex::contains(int day) {
+	return !counts.empty() && day >= firstDay && day <= getLastDay();
+}
+
+int DateIndex::firstIndexOf(int day) {
+	if (!contains(day)) return -1;
+	return starts[day - firstDay];
+}
+
+int DateIndex::gameCountOf(int day) {
+	if (!contains(day)) return 0;
+	return counts[day - firstDay];
+}
+
+int DateIndex::dayOf(int gameIndex) {
+	if (counts.empty() || gameIndex < 0 || gameIndex >= starts.back() + counts.back()) return -1;
+	//last day starting at or before gameIndex; empty days share their start with the next day, so take the last of a run
+	auto it = std::upper_bound(starts.begin(), starts.end(), gameIndex);
+	return firstDay + (int)(it - starts.begin()) - 1;
+}
+
+void DateIndex::rebuildStarts() {
+	//a handful of days at most, see MAX_LOADED_DAYS
+	starts.resize(counts.size());
+	int start = 0;
+	for (size_t i = 0; i < counts.size(); i++) {
+		starts[i] = start;
+		start += counts[i];
+	}
+}
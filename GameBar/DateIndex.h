@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ScheduleParser.h"
+
+//Days are counted from 1970-01-01, so adjacent calendar days are adjacent integers.
+//Parses "YYYY-MM-DD", -1 if it isn't one.
+int parseDay(std::string_view date);
+std::string formatDay(int day);
+//Parses a UTC "YYYY-MM-DDTHH:MM:SSZ" timestamp to seconds since 1970, -1 if it isn't one.
+int64_t parseTime(std::string_view timestamp);
+//When game starts, in seconds since 1970: its gameDate, or midnight of its officialDate if that is missing.
+//Games order by this within a day.
+int64_t gameStartTime(const GameRecord& game);
+
+//Which calendar days the carousel holds and where each one's games start. The loaded days are always one
+//contiguous run, each day's games following the previous day's, so finding a day is a subtraction and
+//finding the day of a game is a binary search over the day starts.
+class DateIndex
+{
+public:
+	bool empty();
+	void clear();
+
+	//Adds day after the last loaded day (or as the only one), holding gameCount games.
+	void append(int day, int gameCount);
+	//Adds day before the first loaded day, holding gameCount games. Every later day's games move up by gameCount.
+	void prepend(int day, int gameCount);
+	//Grows a loaded day by count games, or shrinks it if count is negative. Later days' games move by count.
+	void addGames(int day, int count);
+	//Drops the first or last loaded day. Dropping the first moves every later day's games down.
+	void popFront();
+	void popBack();
+
+	int getFirstDay();
+	int getLastDay();
+	int getDayCount();
+	bool contains(int day);
+
+	//Index of day's first game, or of the next day's if it has none. -1 if day isn't loaded.
+	int firstIndexOf(int day);
+	//number of games on a loaded day
+	int gameCountOf(int day);
+	//Day holding game index, -1 if none does.
+	int dayOf(int gameIndex);
+
+private:
+	void rebuildStarts();
+
+	int firstDay = 0;
+	//games per loaded day, in day order
+	std::vector<int> counts;
+	//index of each loaded day's first game, in day order
+	std::vector<int> starts;
+};
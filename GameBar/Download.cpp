@@ -0,0 +1,216 @@
+#include "Download.h"
+#include "Constants.h"
+#include "Metrics.h"
+#include "PhaseTimer.h"
+#include "Trace.h"
+#include "Watchdog.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <iostream>
+#include <list>
+#include <curlpp/cURLpp.hpp>
+#include <curlpp/Easy.hpp>
+#include <curlpp/Options.hpp>
+#include <curlpp/Infos.hpp>
+
+//set once before any fetch, read by every download thread after
+static std::string originOverride;
+
+void setOrigin(const std::string& origin) {
+	originOverride = origin;
+	//"http://localhost:8090/" and "http://localhost:8090" mean the same
+	while (!originOverride.empty() && originOverride.back() == '/') {
+		originOverride.pop_back();
+	}
+}
+
+std::string resolveUrl(const std::string& url) {
+	if (originOverride.empty()) return url;
+	size_t schemeEnd = url.find("://");
+	if (schemeEnd == std::string::npos) return url;
+	return originOverride + "/" + url.substr(0, schemeEnd) + "/" + url.substr(schemeEnd + 3);
+}
+
+uint64_t getDownloadedBytes() {
+	return httpBytes[HTTP_IMAGE].get() + httpBytes[HTTP_SCHEDULE].get() + httpBytes[HTTP_POLL].get();
+}
+
+//Splits a finished transfer that started at start into curl's stages, on the thread's trace flow.
+static void traceTransfer(curlpp::Easy& request, Uint64 start) {
+	Uint64 flow = getTraceFlow();
+	if (flow == 0) return;
+	double ticksPerSecond = (double)SDL_GetPerformanceFrequency();
+	//seconds from the start of the transfer to the end of each stage
+	Uint64 dns = start + (Uint64)(curlpp::infos::NameLookupTime::get(request) * ticksPerSecond);
+	Uint64 connect = start + (Uint64)(curlpp::infos::ConnectTime::get(request) * ticksPerSecond);
+	Uint64 firstByte = start + (Uint64)(curlpp::infos::StartTransferTime::get(request) * ticksPerSecond);
+	Uint64 end = start + (Uint64)(curlpp::infos::TotalTime::get(request) * ticksPerSecond);
+	traceSpan("network", "dns", start, dns, flow);
+	traceSpan("network", "connect", dns, connect, flow);
+	traceSpan("network", "first byte", connect, firstByte, flow);
+	traceSpan("network", "transfer", firstByte, end, flow);
+}
+
+bool downloadFile(std::string filePath, std::string url, const std::atomic<bool>* wanted) {
+	if (FILE* file = fopen(filePath.c_str(), "r")) {
+		fclose(file);
+		if (getTraceFlow() != 0) {
+			Uint64 now = SDL_GetPerformanceCounter();
+			traceSpan("cache", "on disk", now, now, getTraceFlow());
+		}
+		return true;
+	}
+
+	PhaseTimer timer(PHASE_DOWNLOAD);
+	WatchedUrl watched(url);
+	httpRequests[HTTP_IMAGE].add();
+	//download to a temporary name and rename when complete, so a file that exists is always whole
+	//(several loader jobs may look at the same path)
+	std::string partPath = filePath + ".part";
+	FILE* file = fopen(partPath.c_str(), "wb");
+	if (!file) {
+		std::cout << "Error opening file " << partPath << "!" << std::endl;
+		httpFailures[HTTP_IMAGE].add();
+		return false;
+	}
+	try {
+		curlpp::Easy request;
+		curlpp::options::WriteFunction* writer = new curlpp::options::WriteFunction([file](char* ptr, size_t size, size_t nmemb) {
+			httpBytes[HTTP_IMAGE].add(size * nmemb);
+			return FileCallback(file, ptr, size, nmemb) * size;
+		});
+		request.setOpt(writer);
+		request.setOpt(new curlpp::options::Url(resolveUrl(url)));
+		request.setOpt(new curlpp::options::FailOnError(true));
+		if (wanted) {
+			//curl calls this while data arrives and about once a second otherwise; non-zero aborts the transfer
+			request.setOpt(new curlpp::options::NoProgress(false));
+			request.setOpt(new curlpp::options::ProgressFunction([wanted](double, double, double, double) {
+				return *wanted ? 0 : 1;
+			}));
+		}
+		Uint64 start = SDL_GetPerformanceCounter();
+		request.perform();
+		httpSeconds[HTTP_IMAGE].observeTicks(SDL_GetPerformanceCounter() - start);
+		traceTransfer(request, start);
+		fclose(file);
+	}
+	catch (curlpp::LogicError& e) {
+		std::cout << e.what() << std::endl;
+		fclose(file);
+		remove(partPath.c_str());
+		httpFailures[HTTP_IMAGE].add();
+		return false;
+	}
+	catch (curlpp::RuntimeError& e) {
+		fclose(file);
+		remove(partPath.c_str());
+		//a cancelled transfer isn't worth reporting, nor a failure
+		if (!wanted || *wanted) {
+			std::cout << e.what() << std::endl;
+			httpFailures[HTTP_IMAGE].add();
+		}
+		else {
+			httpCancelled[HTTP_IMAGE].add();
+		}
+		return false;
+	}
+	if (rename(partPath.c_str(), filePath.c_str()) != 0) {
+		//another job got there first
+		remove(partPath.c_str());
+	}
+	return true;
+}
+
+bool downloadString(std::string url, std::string* out) {
+	PhaseTimer timer(PHASE_DOWNLOAD);
+	WatchedUrl watched(url);
+	out->clear();
+	httpRequests[HTTP_SCHEDULE].add();
+	Uint64 start = SDL_GetPerformanceCounter();
+	try {
+		curlpp::Easy request;
+		request.setOpt(new curlpp::options::WriteFunction([out](char* ptr, size_t size, size_t nmemb) {
+			out->append(ptr, size * nmemb);
+			httpBytes[HTTP_SCHEDULE].add(size * nmemb);
+			return size * nmemb;
+		}));
+		request.setOpt(new curlpp::options::Url(resolveUrl(url)));
+		request.setOpt(new curlpp::options::FailOnError(true));
+		request.perform();
+	}
+	catch (curlpp::LogicError& e) {
+		std::cout << e.what() << std::endl;
+		httpFailures[HTTP_SCHEDULE].add();
+		return false;
+	}
+	catch (curlpp::RuntimeError& e) {
+		std::cout << e.what() << std::endl;
+		httpFailures[HTTP_SCHEDULE].add();
+		return false;
+	}
+	httpSeconds[HTTP_SCHEDULE].observeTicks(SDL_GetPerformanceCounter() - start);
+	return true;
+}
+
+long downloadIfChanged(std::string url, std::string* etag, std::string* out) {
+	PhaseTimer timer(PHASE_DOWNLOAD);
+	WatchedUrl watched(url);
+	out->clear();
+	std::string newEtag;
+	long status = 0;
+	httpRequests[HTTP_POLL].add();
+	Uint64 start = SDL_GetPerformanceCounter();
+	try {
+		curlpp::Easy request;
+		request.setOpt(new curlpp::options::WriteFunction([out](char* ptr, size_t size, size_t nmemb) {
+			out->append(ptr, size * nmemb);
+			httpBytes[HTTP_POLL].add(size * nmemb);
+			return size * nmemb;
+		}));
+		request.setOpt(new curlpp::options::HeaderFunction([&newEtag](char* ptr, size_t size, size_t nmemb) {
+			std::string line(ptr, size * nmemb);
+			//header names are case insensitive
+			std::string name = line.substr(0, 5);
+			std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+			if (name == "etag:") {
+				size_t start = line.find_first_not_of(" \t", 5);
+				size_t end = line.find_last_not_of(" \t\r\n");
+				newEtag = start == std::string::npos ? "" : line.substr(start, end + 1 - start);
+			}
+			return size * nmemb;
+		}));
+		if (!etag->empty()) {
+			std::list<std::string> headers;
+			headers.push_back("If-None-Match: " + *etag);
+			request.setOpt(new curlpp::options::HttpHeader(headers));
+		}
+		request.setOpt(new curlpp::options::Url(resolveUrl(url)));
+		request.setOpt(new curlpp::options::FailOnError(true));
+		request.perform();
+		status = curlpp::infos::ResponseCode::get(request);
+	}
+	catch (curlpp::LogicError& e) {
+		std::cout << e.what() << std::endl;
+		httpFailures[HTTP_POLL].add();
+		return 0;
+	}
+	catch (curlpp::RuntimeError& e) {
+		std::cout << e.what() << std::endl;
+		httpFailures[HTTP_POLL].add();
+		return 0;
+	}
+	if (status == 304) {
+		out->clear();
+	}
+	else if (status == 200) {
+		*etag = newEtag;
+	}
+	else {
+		status = 0;
+		httpFailures[HTTP_POLL].add();
+	}
+	httpSeconds[HTTP_POLL].observeTicks(SDL_GetPerformanceCounter() - start);
+	return status;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//Sends every fetch somewhere else: with an origin set, "scheme://host/path" is fetched as origin + "/scheme/host/path",
+//so one local server (ReplayServer.cpp) can stand in for statsapi, the image CDN and anything else a response links
+//to. Empty, the default, fetches urls as they are. Set it before any fetch starts. The update stream isn't
+//redirected: UpdateServer.cpp stands in for that.
+void setOrigin(const std::string& origin);
+//url as it is actually fetched
+std::string resolveUrl(const std::string& url);
+
+//Bytes received by every fetch so far, headers not included.
+uint64_t getDownloadedBytes();
+
+//Downloads url to filePath. Does nothing if filePath already exists.
+//If wanted is given the transfer is abandoned as soon as it goes false, and false is returned.
+bool downloadFile(std::string filePath, std::string url, const std::atomic<bool>* wanted = nullptr);
+
+//Fetches url into out. Returns false on any transfer or HTTP error.
+bool downloadString(std::string url, std::string* out);
+
+//Conditional GET: sends etag as If-None-Match when there is one. Returns 200 with out and etag updated,
+//304 if the resource hasn't changed (out is left empty), or 0 on any transfer or HTTP error.
+long downloadIfChanged(std::string url, std::string* etag, std::string* out);
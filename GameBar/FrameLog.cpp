@@ -0,0 +1,99 @@
+#include "FrameLog.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+static double percentileOf(std::vector<double> values, double p) {
+	if (values.empty()) return 0;
+	size_t rank = std::min(values.size() - 1, (size_t)(p / 100 * values.size()));
+	std::nth_element(values.begin(), values.begin() + rank, values.end());
+	return values[rank];
+}
+
+void FrameLog::add(double frameUs, double renderUs) {
+	frameTimes.push_back(frameUs);
+	renderTimes.push_back(renderUs);
+}
+
+int FrameLog::getCount() {
+	return (int)frameTimes.size();
+}
+
+double FrameLog::percentile(double p) {
+	return percentileOf(frameTimes, p);
+}
+
+double FrameLog::renderPercentile(double p) {
+	return percentileOf(renderTimes, p);
+}
+
+void FrameLog::addTileVisible(double ms) {
+	tileTimes.push_back(ms);
+}
+
+int FrameLog::getTileCount() {
+	return (int)tileTimes.size();
+}
+
+double FrameLog::tilePercentile(double p) {
+	return percentileOf(tileTimes, p);
+}
+
+bool FrameLog::writeCsv(const std::string& path) {
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file) {
+		std::cout << "Error opening file " << path << "!" << std::endl;
+		return false;
+	}
+	fprintf(file, "frame,frame_us,render_us\n");
+	for (size_t i = 0; i < frameTimes.size(); i++) {
+		fprintf(file, "%d,%.0f,%.0f\n", (int)i + 1, frameTimes[i], renderTimes[i]);
+	}
+	return fclose(file) == 0;
+}
+
+void FrameLog::printStats() {
+	if (frameTimes.empty()) return;
+	std::cout << "Frames: " << frameTimes.size() << ", frame time p50 " << percentile(50) / 1000 << " ms, p95 "
+		<< percentile(95) / 1000 << " ms, p99 " << percentile(99) / 1000 << " ms, max " << percentile(100) / 1000
+		<< " ms; render p50 " << renderPercentile(50) / 1000 << " ms, p95 " << renderPercentile(95) / 1000 << " ms" << std::endl;
+	if (!tileTimes.empty()) {
+		std::cout << "Tiles: " << tileTimes.size() << " came on screen, image shown after p50 " << tilePercentile(50)
+			<< " ms, p95 " << tilePercentile(95) << " ms, max " << tilePercentile(100) << " ms" << std::endl;
+	}
+}
+
+double compareImages(const std::string& path, const std::string& golden, int tolerance) {
+	SDL_Surface* loaded[2] = { IMG_Load(path.c_str()), IMG_Load(golden.c_str()) };
+	SDL_Surface* images[2] = { nullptr, nullptr };
+	for (int i = 0; i < 2; i++) {
+		//one layout for both, whatever the PNGs were saved as
+		if (loaded[i]) {
+			images[i] = SDL_ConvertSurfaceFormat(loaded[i], SDL_PIXELFORMAT_ARGB8888, 0);
+			SDL_FreeSurface(loaded[i]);
+		}
+	}
+	double differing = -1;
+	if (images[0] && images[1] && images[0]->w == images[1]->w && images[0]->h == images[1]->h) {
+		long long count = 0;
+		for (int y = 0; y < images[0]->h; y++) {
+			const Uint8* a = (const Uint8*)images[0]->pixels + y * images[0]->pitch;
+			const Uint8* b = (const Uint8*)images[1]->pixels + y * images[1]->pitch;
+			for (int x = 0; x < images[0]->w * 4; x += 4) {
+				for (int channel = 0; channel < 4; channel++) {
+					if (abs(a[x + channel] - b[x + channel]) > tolerance) {
+						count++;
+						break;
+					}
+				}
+			}
+		}
+		differing = (double)count / ((double)images[0]->w * images[0]->h);
+	}
+	SDL_FreeSurface(images[0]);
+	SDL_FreeSurface(images[1]);
+	return differing;
+}
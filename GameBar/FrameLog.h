@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+
+//Time each frame of a run took, for headless runs that gate on rendering cost. Frame time covers the loop's
+//work from checkEvents() on, render time just renderScene(); neither includes the wait before the next frame.
+//Also how long games that came on screen took to show their image.
+class FrameLog
+{
+public:
+	void add(double frameUs, double renderUs);
+	int getCount();
+	//pth percentile (0 to 100) of frame time, in microseconds. 0 without frames.
+	double percentile(double p);
+	double renderPercentile(double p);
+
+	//Records a game coming on screen and showing its image ms later, 0 if it already had it.
+	void addTileVisible(double ms);
+	int getTileCount();
+	double tilePercentile(double p);
+
+	//One "frame,frame_us,render_us" line per frame. Returns false if path couldn't be written.
+	bool writeCsv(const std::string& path);
+	void printStats();
+
+private:
+	std::vector<double> frameTimes;
+	std::vector<double> renderTimes;
+	std::vector<double> tileTimes;
+};
+
+//Compares the PNG at path with golden pixel by pixel; a pixel differs when any channel is more than tolerance off.
+//Returns the fraction of pixels that differ, or -1 if either image is missing or their sizes don't match.
+double compareImages(const std::string& path, const std::string& golden, int tolerance);
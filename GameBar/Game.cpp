@@ -1,176 +1,109 @@
 #include "Game.h"
-#include "Constants.h"
-#include <curlpp/cURLpp.hpp>
-#include <curlpp/Easy.hpp>
-#include <curlpp/Options.hpp>
-#include <SDL2/SDL_image.h>
-
-bool downloadFile(std::string filePath, std::string url) {
-	if (FILE* file = fopen(filePath.c_str(), "r")) {
-		fclose(file);
-		return true;
-	}
-
-	//download file
-	try {
-		curlpp::Cleanup cleaner;
-		curlpp::Easy request;
+#include "GameStore.h"
+#include "Metrics.h"
 
-		FILE* file = fopen(filePath.c_str(), "wb");
-		if (!file) {
-			std::cout << "Error opening file " << filePath << "!" << std::endl;
-			return false;
-		}
-		using namespace std::placeholders;
-		curlpp::options::WriteFunction* writer = new curlpp::options::WriteFunction(std::bind(&FileCallback, file, _1, _2, _3));
-		request.setOpt(writer);
-		request.setOpt(new curlpp::options::Url(url));
-		request.perform();
-		fclose(file);
-	}
-	catch (curlpp::LogicError& e) {
-		std::cout << e.what() << std::endl;
-		return false;
-	}
-	catch (curlpp::RuntimeError& e) {
-		std::cout << e.what() << std::endl;
-		return false;
-	}
-	return true;
+Game::Game(GameStore* store, int index) {
+	games = store;
+	idx = index;
 }
 
-Game::Game(Json::Value json, SDL_Renderer* renderer) {
-	ren = renderer;
-	
-	imgTex = nullptr;
-
-	cached = loaded = false;
-
-	//grab gamePk as uuid
-	uuid = json["gamePk"].asInt();
-
-	//Parse titleText with json sanity checks
-	if (!json["teams"]["home"]["team"]["name"].isString() ||
-		!json["teams"]["away"]["team"]["name"].isString() ||
-		!json["officialDate"].isString()) {
-		titleText = "Unknown";
-	}
-	else {
-		titleText = json["officialDate"].asString() + " " +
-			json["teams"]["away"]["team"]["name"].asString() + " at " +
-			json["teams"]["home"]["team"]["name"].asString();
-		if (json["doubleHeader"].isString() &&
-			json["doubleHeader"].asString() != "N" &&
-			json["gameNumber"].isNumeric()) {
-			titleText += " (Game " + json["gameNumber"].asString() + ")";
-		}
-	}
-	//parse descriptionText with json sanity checks
-	if (json["content"]["editorial"]["recap"]["mlb"]["headline"].isString()) {
-		descriptionText = json["content"]["editorial"]["recap"]["mlb"]["headline"].asString();
-	}
-	else if (json["teams"]["away"]["score"].isNumeric() &&
-		json["teams"]["home"]["score"].isNumeric() &&
-		json["teams"]["home"]["team"]["name"].isString() &&
-		json["teams"]["away"]["team"]["name"].isString()) {
-		int homeScore = json["teams"]["home"]["score"].asInt();
-		int awayScore = json["teams"]["away"]["score"].asInt();
-		descriptionText = std::to_string(awayScore) + "-" + std::to_string(homeScore) + " " +
-			(homeScore > awayScore ? json["teams"]["home"]["team"]["name"].asString() : json["teams"]["away"]["team"]["name"].asString());
-
-	}
-	
-	//populate image url
-	Json::Value cuts = json["content"]["editorial"]["recap"]["mlb"]["media"]["image"]["cuts"];
-	//set img url to default unless we find better
-	imgUrl = "";
-	imgFilename = cacheDir + "\\default.jpg";
-	if (cuts.isArray()) {
-		for (int i = 0; i < cuts.size(); i++) {
-			if (cuts[i]["width"].isNumeric() && cuts[i]["width"].asInt() == LARGE_IMAGE_WIDTH &&
-				cuts[i]["height"].isNumeric() && cuts[i]["height"].asInt() == LARGE_IMAGE_HEIGHT) {
-				imgUrl = cuts[i]["src"].asString();
-				imgFilename = cacheDir + "\\" + std::to_string(uuid) + ".jpg";
-				break;
-			}
-		}
-	}
+LoadHandle Game::requestCache(JobPriority priority) {
+	return games->images->requestFile(games->imageIds[idx], priority);
 }
 
-Game::~Game() {
-	free();
-	uncache();
+LoadHandle Game::requestLoad(JobPriority priority) {
+	return games->images->requestTexture(games->imageIds[idx], priority);
 }
 
-bool Game::cache() {
-	if (cached) return true;
-	cached = downloadFile(imgFilename, imgUrl == "" ? defaultLogoUrl : imgUrl);
-	return cached;
+//Drops a failed load once its image is due another try, so the caller requests it again.
+static void dropIfRetryDue(LoadHandle& handle, ImageRegistry* images, int imageId) {
+	if (handle.getStatus() != LOAD_FAILED || !images->isRetryDue(imageId, SDL_GetTicks())) return;
+	handle.cancel();
+	httpRetries[RETRY_IMAGE].add();
+}
 
+bool Game::cache(JobPriority priority) {
+	LoadHandle& file = games->files[idx];
+	dropIfRetryDue(file, games->images, games->imageIds[idx]);
+	if (file.valid()) return file.getStatus() != LOAD_FAILED;
+	file = requestCache(priority);
+	return file.getStatus() != LOAD_FAILED;
 }
 
 bool Game::uncache() {
-	//kluge to test caching
-	//return true;
-	if (!cached) return true;
-	if (imgUrl != "") {
-		cached = !(remove(imgFilename.c_str()) == 0);
-		return !cached;
-	}
+	games->files[idx].cancel();
+	return true;
 }
 
-bool Game::load() {
+bool Game::load(JobPriority priority) {
+	LoadHandle& tex = games->textures[idx];
+	dropIfRetryDue(tex, games->images, games->imageIds[idx]);
 	//Don't reload already loaded textures
-	if (loaded) {
-		return true;
-	}
-
-	//make sure file exists
-	if (FILE* file = fopen(imgFilename.c_str(), "r")) {
-		fclose(file);
-	} else {
-		if(!cache()) {
-			return false;
-		}
-	}
-	imgTex = IMG_LoadTexture(ren, imgFilename.c_str());
-	if (imgTex == nullptr) {
-		std::cout << "image " << imgFilename << " failed to load" << std::endl;
-		return false;
+	if (tex.valid()) {
+		return tex.getStatus() != LOAD_FAILED;
 	}
-	loaded = true;
-	return true;
+	tex = requestLoad(priority);
+	return tex.getStatus() != LOAD_FAILED;
 }
 
 bool Game::free() {
-	if (loaded) {
-		SDL_DestroyTexture(imgTex);
-		loaded = false;
-	}
+	games->selectedTextures[idx].cancel();
+	games->textures[idx].cancel();
 	return true;
 }
 
 bool Game::isCached() {
-	return cached;
+	return games->files[idx].getStatus() == LOAD_DONE;
 }
 
 bool Game::isLoaded() {
-	return loaded;
+	return games->textures[idx].getStatus() == LOAD_DONE;
 }
 
-SDL_Texture* Game::getImage() {
-	if (!imgTex) {
-		if (!load()) {
-			return nullptr;
+bool Game::isCaching() {
+	return games->files[idx].getStatus() == LOAD_PENDING;
+}
+
+bool Game::isLoading() {
+	return games->textures[idx].getStatus() == LOAD_PENDING;
+}
+
+bool Game::isUpgrading() {
+	return games->selectedTextures[idx].getStatus() == LOAD_PENDING;
+}
+
+SDL_Texture* Game::getImage(bool selected) {
+	load();
+	LoadHandle& upgrade = games->selectedTextures[idx];
+	if (selected) {
+		dropIfRetryDue(upgrade, games->images, games->selectedImageIds[idx]);
+		if (!upgrade.valid() && games->selectedImageIds[idx] != games->imageIds[idx]) {
+			upgrade = games->images->requestTexture(games->selectedImageIds[idx], JOB_PRIORITY_HIGH);
 		}
+		if (upgrade.getTexture()) {
+			games->images->notePresented(games->selectedImageIds[idx]);
+			return upgrade.getTexture();
+		}
+	}
+	else if (upgrade.getStatus() == LOAD_PENDING) {
+		//the selection moved on before the sharper cut arrived
+		upgrade.cancel();
 	}
-	return imgTex;
+	SDL_Texture* texture = games->textures[idx].getTexture();
+	if (texture) {
+		games->images->notePresented(games->imageIds[idx]);
+	}
+	return texture;
 }
 
 std::string Game::getTopText() {
-	return titleText;
+	return games->strings.get(games->titles[idx]);
 }
 
 std::string Game::getBottomText() {
-	return descriptionText;
-}
\ No newline at end of file
+	return games->strings.get(games->descriptions[idx]);
+}
+
+int Game::getId() {
+	return games->ids[idx];
+}
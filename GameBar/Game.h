@@ -1,46 +1,52 @@
 #pragma once
-#include <json/json.h>
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
+#include <string>
+#include "ImageRegistry.h"
 
+class GameStore;
+
+//Handle to one game in a GameStore. Cheap to copy; the store owns the game's data and image references.
 class Game
 {
 public:
-	// Parses a "Game" JSON object into the various components. Stores the URL for the game image(doesn't download it), constructs display texts.
-	Game(Json::Value json, SDL_Renderer* renderer);
+	Game(GameStore* store, int index);
+
+	//Starts downloading the image to the /cache directory, unless another game already has. The caller owns
+	//the returned handle; the file stays cached while it lives and an unfinished download stops once nothing needs it.
+	LoadHandle requestCache(JobPriority priority);
 
-	// Clears all textures and files downloaded for this Game on destruction
-	~Game();
+	//Starts downloading, decoding and uploading the image to a shared texture. Same ownership as requestCache.
+	LoadHandle requestLoad(JobPriority priority);
 
-	//Downloads image to the /cache directory.
-	bool cache();
+	//Queues image download to the /cache directory, unless another game already has. A download that failed is
+	//queued again once its backoff (ImageRegistry::isRetryDue) is over. Returns false while it stands failed.
+	bool cache(JobPriority priority = JOB_PRIORITY_LOW);
 
-	//Deletes image from the /cache directory.
+	//Drops this game's hold on its image file, which stays in the /cache directory for later runs. Calls off an unfinished download.
 	bool uncache();
 	
-	//Pushes image to a texture in memory.
-	bool load();
+	//Queues image decode and upload to a shared texture in memory, retried like cache().
+	bool load(JobPriority priority = JOB_PRIORITY_NORMAL);
 	
-	//Frees texture from memory.
+	//Drops this Game's references to the shared textures. Calls off an unfinished download or decode.
 	bool free();
 	
 	bool isCached();
 	bool isLoaded();
+	//a download or texture load has been asked for and hasn't finished
+	bool isCaching();
+	bool isLoading();
+	//the sharper selected cut has been asked for and hasn't arrived
+	bool isUpgrading();
 
-	SDL_Texture* getImage();
+	//nullptr until the loader has delivered the image. A selected tile also fetches the sharper selected cut
+	//and returns it once ready; an upgrade still pending when the tile is deselected is called off.
+	SDL_Texture* getImage(bool selected = false);
 	std::string getTopText();
 	std::string getBottomText();
+	int getId();
 
 private:
-	SDL_Texture *imgTex;
-	TTF_Font *smFont, *lgFont;
-	SDL_Surface *botText, *topText;
-	SDL_Texture *botTextTex, *topTextTex;
-	std::string imgUrl, imgFilename;
-	std::string titleText, descriptionText;
-	SDL_Renderer* ren;
-	int uuid;
-	bool cached;
-	bool loaded;
+	GameStore* games;
+	int idx;
 };
-
@@ -0,0 +1,416 @@
+#include "GameStore.h"
+#include "Constants.h"
+#include "DateIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+static_assert(std::is_nothrow_move_constructible<LoadHandle>::value, "column growth must move, not copy, load handles");
+
+//cuts within this much of the tile's aspect ratio are drawn without visible stretching
+static const float ASPECT_TOLERANCE = 0.05f;
+
+//Index into cuts of the smallest cut at least width x height, preferring the tile's aspect ratio.
+//If none is large enough the largest is used. -1 if there are no cuts.
+static int bestCut(const ImageCut* cuts, int count, int width, int height) {
+	float aspect = (float)width / height;
+	bool anyMatchAspect = false;
+	for (int i = 0; i < count; i++) {
+		if (cuts[i].height > 0 && std::fabs((float)cuts[i].width / cuts[i].height - aspect) <= aspect * ASPECT_TOLERANCE) {
+			anyMatchAspect = true;
+		}
+	}
+	int best = -1;
+	int largest = -1;
+	for (int i = 0; i < count; i++) {
+		if (cuts[i].height <= 0) continue;
+		if (anyMatchAspect && std::fabs((float)cuts[i].width / cuts[i].height - aspect) > aspect * ASPECT_TOLERANCE) continue;
+		long long area = (long long)cuts[i].width * cuts[i].height;
+		if (largest < 0 || area > (long long)cuts[largest].width * cuts[largest].height) {
+			largest = i;
+		}
+		if (cuts[i].width >= width && cuts[i].height >= height &&
+			(best < 0 || area < (long long)cuts[best].width * cuts[best].height)) {
+			best = i;
+		}
+	}
+	return best >= 0 ? best : largest;
+}
+
+//Moves the last count entries of column to position, keeping the order of both parts.
+template <typename T>
+static void rotateTail(std::vector<T>& column, int position, int count) {
+	std::rotate(column.begin() + position, column.end() - count, column.end());
+}
+
+//Moves the entry at from to to, the entries between shifting by one toward from.
+template <typename T>
+static void moveEntry(std::vector<T>& column, int from, int to) {
+	if (from < to) {
+		std::rotate(column.begin() + from, column.begin() + from + 1, column.begin() + to + 1);
+	}
+	else {
+		std::rotate(column.begin() + to, column.begin() + from, column.begin() + from + 1);
+	}
+}
+
+template <typename T>
+static void eraseRange(std::vector<T>& column, int first, int count) {
+	column.erase(column.begin() + first, column.begin() + first + count);
+}
+
+GameStore::GameStore(ImageRegistry* registry) {
+	images = registry;
+	displayScale = 1;
+	compactedBytes = 0;
+}
+
+void GameStore::reserve(int count) {
+	ids.reserve(count);
+	imageIds.reserve(count);
+	selectedImageIds.reserve(count);
+	files.reserve(count);
+	textures.reserve(count);
+	selectedTextures.reserve(count);
+	firstCuts.reserve(count);
+	cutCounts.reserve(count);
+	editorialStates.reserve(count);
+	fingerprints.reserve(count);
+	startTimes.reserve(count);
+	indexById.reserve(count);
+	titles.reserve(count);
+	descriptions.reserve(count);
+	//titles and headlines run well under 128 characters, and each game has a dozen or so cut urls of about that length
+	strings.reserve((size_t)count * 128 * 14);
+}
+
+//Builds a game's title with sanity checks.
+static std::string makeTitle(const GameRecord& game) {
+	if (!isPresent(game.homeName) || !isPresent(game.awayName) || !isPresent(game.officialDate)) {
+		return "Unknown";
+	}
+	std::string titleText = jsonUnescape(game.officialDate) + " " + jsonUnescape(game.awayName) + " at " + jsonUnescape(game.homeName);
+	if (isPresent(game.doubleHeader) && game.doubleHeader != "N" && game.hasGameNumber) {
+		titleText += " (Game " + std::to_string(game.gameNumber) + ")";
+	}
+	return titleText;
+}
+
+//Builds a game's description with sanity checks: the recap headline if there is one, otherwise the score.
+static std::string makeDescription(const GameRecord& game) {
+	if (isPresent(game.headline)) {
+		return jsonUnescape(game.headline);
+	}
+	if (game.hasAwayScore && game.hasHomeScore && isPresent(game.homeName) && isPresent(game.awayName)) {
+		return std::to_string(game.awayScore) + "-" + std::to_string(game.homeScore) + " " +
+			jsonUnescape(game.homeScore > game.awayScore ? game.homeName : game.awayName);
+	}
+	return "";
+}
+
+int GameStore::addGame(const GameRecord& game, const std::vector<CutRecord>& cuts) {
+	int index = (int)ids.size();
+	//grab gamePk as uuid
+	ids.push_back(game.gamePk);
+	indexById[game.gamePk] = index;
+
+	firstCuts.push_back(0);
+	cutCounts.push_back(0);
+	imageIds.push_back(-1);
+	selectedImageIds.push_back(-1);
+	addCuts(index, game, cuts);
+	chooseImages(index);
+	files.emplace_back();
+	textures.emplace_back();
+	selectedTextures.emplace_back();
+	editorialStates.push_back(game.cutCount > 0 || isPresent(game.headline) ? EDITORIAL_DONE : EDITORIAL_NONE);
+	fingerprints.push_back(gameFingerprint(game));
+	startTimes.push_back(gameStartTime(game));
+
+	titles.push_back(strings.intern(makeTitle(game)));
+	descriptions.push_back(strings.intern(makeDescription(game)));
+	return index;
+}
+
+int GameStore::addStoredGame(const StoredGame& game, const StoredCut* gameCuts, int cutCount) {
+	int index = (int)ids.size();
+	ids.push_back(game.gamePk);
+	indexById[game.gamePk] = index;
+
+	firstCuts.push_back((int)cuts.size());
+	for (int i = 0; i < cutCount; i++) {
+		ImageCut cut;
+		cut.width = gameCuts[i].width;
+		cut.height = gameCuts[i].height;
+		cut.url = strings.intern(std::string(gameCuts[i].url));
+		cuts.push_back(cut);
+	}
+	cutCounts.push_back(cutCount);
+	imageIds.push_back(-1);
+	selectedImageIds.push_back(-1);
+	chooseImages(index);
+	files.emplace_back();
+	textures.emplace_back();
+	selectedTextures.emplace_back();
+	//a fetch that was still out when the snapshot was written is asked for again
+	editorialStates.push_back(game.editorialState == EDITORIAL_DONE ? EDITORIAL_DONE : EDITORIAL_NONE);
+	fingerprints.push_back(game.fingerprint);
+	startTimes.push_back(game.startTime);
+
+	titles.push_back(strings.intern(std::string(game.title)));
+	descriptions.push_back(strings.intern(std::string(game.description)));
+	return index;
+}
+
+StoredGame GameStore::getStoredGame(int index) {
+	StoredGame game;
+	game.gamePk = ids[index];
+	game.title = std::string_view(strings.c_str(titles[index]), titles[index].length);
+	game.description = std::string_view(strings.c_str(descriptions[index]), descriptions[index].length);
+	game.editorialState = (EditorialState)editorialStates[index];
+	game.fingerprint = fingerprints[index];
+	game.startTime = startTimes[index];
+	return game;
+}
+
+int GameStore::getCutCount(int index) {
+	return cutCounts[index];
+}
+
+StoredCut GameStore::getStoredCut(int index, int cut) {
+	const ImageCut& stored = cuts[firstCuts[index] + cut];
+	StoredCut out;
+	out.width = stored.width;
+	out.height = stored.height;
+	out.url = std::string_view(strings.c_str(stored.url), stored.url.length);
+	return out;
+}
+
+int GameStore::mergeEditorial(const GameRecord& game, const std::vector<CutRecord>& cuts) {
+	int index = indexOf(game.gamePk);
+	if (index < 0) return -1;
+	editorialStates[index] = EDITORIAL_DONE;
+	fingerprints[index] = gameFingerprint(game);
+	//no recap yet, the score stays
+	if (isPresent(game.headline)) {
+		descriptions[index] = strings.intern(makeDescription(game));
+	}
+	mergeCuts(index, game, cuts);
+	return index;
+}
+
+int GameStore::patchGame(const GameRecord& game, uint64_t fingerprint, const std::vector<CutRecord>& cuts, bool* textChanged) {
+	*textChanged = false;
+	int index = indexOf(game.gamePk);
+	if (index < 0 || fingerprints[index] == fingerprint) return -1;
+	fingerprints[index] = fingerprint;
+	//a delayed game is put back in order by the caller, see findPosition()
+	startTimes[index] = gameStartTime(game);
+	bool& changed = *textChanged;
+	std::string title = makeTitle(game);
+	if (title != strings.c_str(titles[index])) {
+		titles[index] = strings.intern(title);
+		changed = true;
+	}
+	//the refresh carries the recap, so a missing headline really means the score
+	std::string description = makeDescription(game);
+	if (description != strings.c_str(descriptions[index])) {
+		descriptions[index] = strings.intern(description);
+		changed = true;
+	}
+	//images are only filled in for a game that had none, an image already chosen is never downloaded again
+	if (editorialStates[index] != EDITORIAL_DONE && (game.cutCount > 0 || isPresent(game.headline))) {
+		editorialStates[index] = EDITORIAL_DONE;
+		mergeCuts(index, game, cuts);
+	}
+	//replaced strings stay in the arena until the next compaction; don't let a long live session pile them up
+	if (strings.size() > compactedBytes * 2 + 4096) {
+		compact();
+	}
+	return index;
+}
+
+void GameStore::mergeCuts(int index, const GameRecord& game, const std::vector<CutRecord>& cuts) {
+	if (game.cutCount == 0) return;
+	addCuts(index, game, cuts);
+	int oldImage = imageIds[index];
+	chooseImages(index);
+	//games already showing the placeholder switch to the real image; the new handle is taken before the old is dropped
+	if (imageIds[index] != oldImage) {
+		if (files[index].valid()) {
+			files[index] = images->requestFile(imageIds[index], JOB_PRIORITY_LOW);
+		}
+		if (textures[index].valid()) {
+			textures[index] = images->requestTexture(imageIds[index], JOB_PRIORITY_NORMAL);
+		}
+	}
+	selectedTextures[index].cancel();
+}
+
+void GameStore::addCuts(int index, const GameRecord& game, const std::vector<CutRecord>& cuts) {
+	//keep every cut, the one to draw depends on tile state and display scale.
+	//a game's cuts are appended once more when it is hydrated; the earlier range is simply abandoned
+	firstCuts[index] = (int)this->cuts.size();
+	for (int i = game.firstCut; i < game.firstCut + game.cutCount; i++) {
+		if (!isPresent(cuts[i].src)) continue;
+		ImageCut cut;
+		cut.width = cuts[i].width;
+		cut.height = cuts[i].height;
+		cut.url = strings.intern(jsonUnescape(cuts[i].src));
+		this->cuts.push_back(cut);
+	}
+	cutCounts[index] = (int)this->cuts.size() - firstCuts[index];
+}
+
+void GameStore::setDisplayScale(float scale) {
+	if (scale == displayScale) return;
+	displayScale = scale;
+	for (int i = 0; i < size(); i++) {
+		chooseImages(i);
+	}
+}
+
+void GameStore::chooseImages(int index) {
+	const ImageCut* gameCuts = cuts.data() + firstCuts[index];
+	int count = cutCounts[index];
+	int small = bestCut(gameCuts, count, (int)std::ceil(SMALL_IMAGE_WIDTH * displayScale), (int)std::ceil(SMALL_IMAGE_HEIGHT * displayScale));
+	int large = bestCut(gameCuts, count, (int)std::ceil(LARGE_IMAGE_WIDTH * displayScale), (int)std::ceil(LARGE_IMAGE_HEIGHT * displayScale));
+	//fall back to the default image when a game has no cuts. Register the new ids before dropping the old,
+	//so an unchanged image is never forgotten in between
+	int oldImage = imageIds[index];
+	int oldSelectedImage = selectedImageIds[index];
+	imageIds[index] = images->registerImage(small >= 0 ? strings.get(gameCuts[small].url) : defaultLogoUrl);
+	selectedImageIds[index] = images->registerImage(large >= 0 ? strings.get(gameCuts[large].url) : defaultLogoUrl);
+	images->unregisterImage(oldImage);
+	images->unregisterImage(oldSelectedImage);
+}
+
+int GameStore::insertGames(int position, const GameRecord* games, int count, const std::vector<CutRecord>& cuts) {
+	//append, then rotate every column so the new games sit at position. Handles only move, so games
+	//already loaded keep their textures
+	for (int i = 0; i < count; i++) {
+		addGame(games[i], cuts);
+	}
+	if (position < size() - count) {
+		rotateTail(ids, position, count);
+		rotateTail(imageIds, position, count);
+		rotateTail(selectedImageIds, position, count);
+		rotateTail(files, position, count);
+		rotateTail(textures, position, count);
+		rotateTail(selectedTextures, position, count);
+		rotateTail(titles, position, count);
+		rotateTail(descriptions, position, count);
+		rotateTail(firstCuts, position, count);
+		rotateTail(cutCounts, position, count);
+		rotateTail(editorialStates, position, count);
+		rotateTail(fingerprints, position, count);
+		rotateTail(startTimes, position, count);
+		rebuildIndex();
+	}
+	return count;
+}
+
+void GameStore::eraseGames(int first, int count) {
+	if (count <= 0) return;
+	//handles release their images as they go
+	eraseRange(selectedTextures, first, count);
+	eraseRange(textures, first, count);
+	eraseRange(files, first, count);
+	for (int i = first; i < first + count; i++) {
+		images->unregisterImage(imageIds[i]);
+		images->unregisterImage(selectedImageIds[i]);
+	}
+	eraseRange(ids, first, count);
+	eraseRange(imageIds, first, count);
+	eraseRange(selectedImageIds, first, count);
+	eraseRange(titles, first, count);
+	eraseRange(descriptions, first, count);
+	eraseRange(firstCuts, first, count);
+	eraseRange(cutCounts, first, count);
+	eraseRange(editorialStates, first, count);
+	eraseRange(fingerprints, first, count);
+	eraseRange(startTimes, first, count);
+	rebuildIndex();
+	compact();
+}
+
+int GameStore::findPosition(int first, int last, int64_t startTime) {
+	return (int)(std::upper_bound(startTimes.begin() + first, startTimes.begin() + last, startTime) - startTimes.begin());
+}
+
+void GameStore::moveGame(int from, int to) {
+	if (from == to) return;
+	moveEntry(ids, from, to);
+	moveEntry(imageIds, from, to);
+	moveEntry(selectedImageIds, from, to);
+	moveEntry(files, from, to);
+	moveEntry(textures, from, to);
+	moveEntry(selectedTextures, from, to);
+	moveEntry(titles, from, to);
+	moveEntry(descriptions, from, to);
+	moveEntry(firstCuts, from, to);
+	moveEntry(cutCounts, from, to);
+	moveEntry(editorialStates, from, to);
+	moveEntry(fingerprints, from, to);
+	moveEntry(startTimes, from, to);
+	//only the games between moved
+	for (int i = std::min(from, to); i <= std::max(from, to); i++) {
+		indexById[ids[i]] = i;
+	}
+}
+
+int64_t GameStore::getStartTime(int index) {
+	return startTimes[index];
+}
+
+void GameStore::rebuildIndex() {
+	indexById.clear();
+	for (int i = 0; i < size(); i++) {
+		indexById[ids[i]] = i;
+	}
+}
+
+void GameStore::compact() {
+	//the arena and cut column are append only; copy what the remaining games use into fresh ones
+	StringArena freshStrings;
+	std::vector<ImageCut> freshCuts;
+	for (int i = 0; i < size(); i++) {
+		titles[i] = freshStrings.intern(strings.get(titles[i]));
+		descriptions[i] = freshStrings.intern(strings.get(descriptions[i]));
+		int first = (int)freshCuts.size();
+		for (int c = firstCuts[i]; c < firstCuts[i] + cutCounts[i]; c++) {
+			ImageCut cut = cuts[c];
+			cut.url = freshStrings.intern(strings.get(cut.url));
+			freshCuts.push_back(cut);
+		}
+		firstCuts[i] = first;
+	}
+	strings = std::move(freshStrings);
+	cuts.swap(freshCuts);
+	compactedBytes = strings.size();
+}
+
+void GameStore::clear() {
+	eraseGames(0, size());
+}
+
+int GameStore::indexOf(int gamePk) {
+	auto existing = indexById.find(gamePk);
+	return existing == indexById.end() ? -1 : existing->second;
+}
+
+EditorialState GameStore::getEditorialState(int index) {
+	return (EditorialState)editorialStates[index];
+}
+
+void GameStore::setEditorialState(int index, EditorialState state) {
+	editorialStates[index] = (Uint8)state;
+}
+
+int GameStore::size() {
+	return (int)ids.size();
+}
+
+Game GameStore::operator[](int index) {
+	return Game(this, index);
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Game.h"
+#include "ImageRegistry.h"
+#include "ScheduleParser.h"
+#include "StringArena.h"
+
+//Whether a game's headline and image cuts (the schedule's editorial hydration) have been fetched.
+enum EditorialState {
+	EDITORIAL_NONE,
+	EDITORIAL_REQUESTED,
+	EDITORIAL_DONE,
+	EDITORIAL_FAILED
+};
+
+//One available rendition of a game's image.
+struct ImageCut {
+	int width = 0;
+	int height = 0;
+	StringRef url;
+};
+
+//A game's stored fields as a snapshot keeps them (see Snapshot.h): display text already built, cut urls unescaped.
+struct StoredGame {
+	int gamePk = 0;
+	std::string_view title;
+	std::string_view description;
+	EditorialState editorialState = EDITORIAL_NONE;
+	uint64_t fingerprint = 0;
+	int64_t startTime = 0;
+};
+
+struct StoredCut {
+	int width = 0;
+	int height = 0;
+	std::string_view url;
+};
+
+//Column oriented storage for a schedule's games. Fields touched while scrolling (ids, image ids and the
+//image file/texture load handles that make up cache state) are packed in their own arrays; display strings
+//are interned in an arena. Games are accessed through lightweight Game handles.
+class GameStore
+{
+public:
+	GameStore(ImageRegistry* registry);
+	GameStore(const GameStore&) = delete;
+	GameStore& operator=(const GameStore&) = delete;
+
+	//Pre-sizes every column for count games.
+	void reserve(int count);
+
+	//Picks image cuts for tiles drawn at scale output pixels per layout pixel (1 at 1080p, 2 on a 4K panel).
+	//Call before any game is cached or loaded; games already holding images keep them.
+	void setDisplayScale(float scale);
+
+	//Copies an extracted schedule game into the columns. Keeps every image cut and picks the ones to use(doesn't download them), constructs display texts.
+	//cuts is the ScheduleRecords::cuts array game's cut range refers to. Returns the new game's index.
+	int addGame(const GameRecord& game, const std::vector<CutRecord>& cuts);
+
+	//Appends a game read back from a snapshot, with its cuts, as addGame() would have built it. Returns its index.
+	int addStoredGame(const StoredGame& game, const StoredCut* gameCuts, int cutCount);
+
+	//A game's stored fields and cuts, for writing a snapshot. The views point into the store and are only good
+	//until it next changes.
+	StoredGame getStoredGame(int index);
+	int getCutCount(int index);
+	StoredCut getStoredCut(int index, int cut);
+
+	//Inserts count games at position, before the game currently there (or appends at size()). Games after
+	//position move up by count but keep their images and handles. Returns count.
+	int insertGames(int position, const GameRecord* games, int count, const std::vector<CutRecord>& cuts);
+
+	//Removes count games starting at first, releasing their images. Later games move down by count.
+	//Reclaims the string and cut storage the removed games used.
+	void eraseGames(int first, int count);
+
+	//Fills in a game added from the bare schedule with its editorial content: headline and image cuts. The game
+	//keeps its index and handles; a game already showing the placeholder image is switched to the real one.
+	//Returns the game's index, or -1 if gamePk isn't in the store.
+	int mergeEditorial(const GameRecord& game, const std::vector<CutRecord>& cuts);
+
+	//Applies a live refresh of a game already in the store, if its fingerprint (see gameFingerprint()) differs:
+	//only a title or description that actually changed is replaced, and cuts only hydrate a game that has no
+	//editorial content yet. Handles and images are left alone. Returns the game's index, or -1 if there was nothing
+	//to patch; textChanged says whether its title or description needs rendering again.
+	int patchGame(const GameRecord& game, uint64_t fingerprint, const std::vector<CutRecord>& cuts, bool* textChanged);
+
+	//Where a game starting at startTime belongs among games first..last-1, which are in start order: the index
+	//after every game starting at or before it.
+	int findPosition(int first, int last, int64_t startTime);
+
+	//Moves game from to index to, the games between shifting by one. Its handles and images go with it.
+	void moveGame(int from, int to);
+
+	int64_t getStartTime(int index);
+
+	//Index of the game with gamePk, -1 if there is none.
+	int indexOf(int gamePk);
+
+	EditorialState getEditorialState(int index);
+	void setEditorialState(int index, EditorialState state);
+
+	//Drops every game, releasing their image references.
+	void clear();
+
+	int size();
+	Game operator[](int index);
+
+private:
+	friend class Game;
+
+	//Registers the best cut for each tile state of game index.
+	void chooseImages(int index);
+	//Copies game's cuts into the cut column as index's range.
+	void addCuts(int index, const GameRecord& game, const std::vector<CutRecord>& cuts);
+	//Takes game's cuts as index's and switches a game showing the placeholder to the real image.
+	void mergeCuts(int index, const GameRecord& game, const std::vector<CutRecord>& cuts);
+	//Recomputes indexById after games moved.
+	void rebuildIndex();
+	//Rebuilds the string arena and cut column with only what the current games use.
+	void compact();
+
+	ImageRegistry* images;
+	float displayScale;
+
+	//hot columns. imageIds is the cut for an unselected tile, cached and loaded by the prefetch window;
+	//selectedImageIds is the sharper cut a selected tile upgrades to, often the same image.
+	std::vector<int> ids;
+	std::vector<int> imageIds;
+	std::vector<int> selectedImageIds;
+	std::vector<LoadHandle> files;
+	std::vector<LoadHandle> textures;
+	std::vector<LoadHandle> selectedTextures;
+
+	//cold columns
+	std::vector<StringRef> titles;
+	std::vector<StringRef> descriptions;
+	std::vector<int> firstCuts;
+	std::vector<int> cutCounts;
+	std::vector<ImageCut> cuts;
+	std::vector<Uint8> editorialStates;
+	//gameFingerprint() of the record each game's text was last built from
+	std::vector<uint64_t> fingerprints;
+	//gameStartTime(), each day's games are in this order
+	std::vector<int64_t> startTimes;
+	std::unordered_map<int, int> indexById;
+	StringArena strings;
+	//arena size after the last compaction
+	size_t compactedBytes;
+};
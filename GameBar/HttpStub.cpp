@@ -0,0 +1,67 @@
+#include "HttpStub.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+Socket listenLocal(int port, int backlog) {
+#ifdef _WIN32
+	WSADATA wsa;
+	WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+	Socket listener = socket(AF_INET, SOCK_STREAM, 0);
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons((unsigned short)port);
+	if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, backlog) != 0) {
+		std::cout << "Can't listen on port " << port << std::endl;
+		closesocket(listener);
+		return INVALID_SOCKET;
+	}
+	return listener;
+}
+
+void acceptForever(Socket listener, void (*serve)(Socket client)) {
+	while (true) {
+		Socket client = accept(listener, nullptr, nullptr);
+		if (client == INVALID_SOCKET) continue;
+		std::thread(serve, client).detach();
+	}
+}
+
+std::string readRequest(Socket client) {
+	std::string request;
+	char buffer[4096];
+	while (request.find("\r\n\r\n") == std::string::npos) {
+		int n = recv(client, buffer, sizeof(buffer), 0);
+		if (n <= 0) break;
+		request.append(buffer, n);
+	}
+	return request;
+}
+
+std::string requestPath(const std::string& request) {
+	size_t pathStart = request.find(' ') + 1;
+	return request.substr(pathStart, request.find(' ', pathStart) - pathStart);
+}
+
+std::string header(const std::string& request, const std::string& name) {
+	std::string lower = request;
+	std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+	size_t at = lower.find("\r\n" + name + ":");
+	if (at == std::string::npos) return "";
+	size_t start = request.find_first_not_of(' ', at + name.size() + 3);
+	return request.substr(start, request.find("\r\n", start) - start);
+}
+
+bool sendAll(Socket client, const std::string& data) {
+	size_t sent = 0;
+	while (sent < data.size()) {
+		int n = send(client, data.data() + sent, (int)(data.size() - sent), 0);
+		if (n <= 0) return false;
+		sent += n;
+	}
+	return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <string>
+#ifdef _WIN32
+#include <winsock2.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET Socket;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int Socket;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+#endif
+
+//Bare HTTP/1.1 serving shared by the stand-in servers (ReplayServer.cpp, UpdateServer.cpp): one request per
+//connection, each on a thread of its own, answered with "Connection: close".
+
+//Starts sockets and listens on localhost:port. Returns INVALID_SOCKET, having said why, if it can't.
+Socket listenLocal(int port, int backlog);
+
+//Accepts connections for good, handing each to serve on a detached thread. serve closes the socket.
+void acceptForever(Socket listener, void (*serve)(Socket client));
+
+//Reads a request up to the end of its headers; the body, if any, isn't read.
+std::string readRequest(Socket client);
+
+//The request line's path, query string included.
+std::string requestPath(const std::string& request);
+
+//Value of header name (lower case) in request, "" if it isn't there.
+std::string header(const std::string& request, const std::string& name);
+
+//Sends all of data. False if the connection went.
+bool sendAll(Socket client, const std::string& data);
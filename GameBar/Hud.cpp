@@ -0,0 +1,115 @@
+#include "Hud.h"
+#include "Constants.h"
+#include "PhaseTimer.h"
+#include <SDL2/SDL_ttf.h>
+#include <cstdio>
+#include <iostream>
+
+Hud::Hud(SDL_Renderer* renderer) {
+	ren = renderer;
+	glyphTex = nullptr;
+	lineHeight = 0;
+	visible = false;
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		glyphs[i] = { 0, 0, 0, 0 };
+		advances[i] = 0;
+	}
+
+	TTF_Font* font = TTF_OpenFont(fontFile.c_str(), HUD_FONT_SIZE);
+	if (!font) {
+		std::cout << "HUD font failed to load" << std::endl;
+		return;
+	}
+	lineHeight = TTF_FontLineSkip(font);
+	//glyphs side by side in one strip
+	SDL_Surface* rendered[GLYPH_COUNT];
+	int width = 0;
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		rendered[i] = TTF_RenderGlyph_Blended(font, (Uint16)(FIRST_GLYPH + i), uiColor);
+		TTF_GlyphMetrics(font, (Uint16)(FIRST_GLYPH + i), nullptr, nullptr, nullptr, nullptr, &advances[i]);
+		if (rendered[i]) {
+			glyphs[i] = { width, 0, rendered[i]->w, rendered[i]->h };
+			width += rendered[i]->w;
+		}
+	}
+	SDL_Surface* strip = SDL_CreateRGBSurfaceWithFormat(0, width > 0 ? width : 1, lineHeight > 0 ? lineHeight : 1, 32, SDL_PIXELFORMAT_ARGB8888);
+	for (int i = 0; i < GLYPH_COUNT; i++) {
+		if (!rendered[i]) continue;
+		if (strip) {
+			//copy the glyph's alpha as is rather than blending it onto nothing
+			SDL_SetSurfaceBlendMode(rendered[i], SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(rendered[i], nullptr, strip, &glyphs[i]);
+		}
+		SDL_FreeSurface(rendered[i]);
+	}
+	if (strip) {
+		glyphTex = SDL_CreateTextureFromSurface(ren, strip);
+		SDL_FreeSurface(strip);
+	}
+	TTF_CloseFont(font);
+}
+
+Hud::~Hud() {
+	SDL_DestroyTexture(glyphTex);
+}
+
+void Hud::toggle() {
+	visible = !visible;
+}
+
+bool Hud::isVisible() {
+	return visible;
+}
+
+int Hud::drawText(const char* text, int x, int y) {
+	for (const char* c = text; *c; c++) {
+		int i = (unsigned char)*c - FIRST_GLYPH;
+		if (i < 0 || i >= GLYPH_COUNT) continue;
+		SDL_Rect to = { x, y, glyphs[i].w, glyphs[i].h };
+		SDL_RenderCopy(ren, glyphTex, &glyphs[i], &to);
+		x += advances[i];
+	}
+	return x;
+}
+
+void Hud::draw() {
+	if (!visible || !glyphTex) return;
+	//columns at fixed offsets, the font isn't monospaced
+	const int columns[] = { 0, 90, 160, 230, 300, 370 };
+	const int margin = 10;
+	//a heading, the phases, another heading and the input sources
+	SDL_Rect panel = { margin, margin, columns[5] + 70 + 2 * margin, (PHASE_COUNT + INPUT_SOURCE_COUNT + 2) * lineHeight + 2 * margin };
+	SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderDrawColor(ren, 0, 0, 0, 160);
+	SDL_RenderFillRect(ren, &panel);
+	SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+
+	int x = panel.x + margin;
+	int y = panel.y + margin;
+	const char* headings[] = { "ms", "count", "p50", "p95", "p99", "max" };
+	for (int c = 0; c < 6; c++) {
+		drawText(headings[c], x + columns[c], y);
+	}
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		y += lineHeight;
+		drawRow(phaseName((Phase)phase), summarizePhase((Phase)phase), x, y, columns);
+	}
+	y += lineHeight;
+	drawText("input to photon", x + columns[0], y);
+	for (int source = 0; source < INPUT_SOURCE_COUNT; source++) {
+		y += lineHeight;
+		drawRow(inputSourceName((InputSource)source), summarizeInput((InputSource)source), x, y, columns);
+	}
+}
+
+void Hud::drawRow(const char* name, const PhaseSummary& summary, int x, int y, const int* columns) {
+	char cell[32];
+	double values[] = { summary.p50Us, summary.p95Us, summary.p99Us, summary.maxUs };
+	drawText(name, x + columns[0], y);
+	snprintf(cell, sizeof(cell), "%u", summary.count);
+	drawText(cell, x + columns[1], y);
+	for (int c = 0; c < 4; c++) {
+		snprintf(cell, sizeof(cell), "%.2f", values[c] / 1000);
+		drawText(cell, x + columns[c + 2], y);
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "PhaseTimer.h"
+#include <SDL2/SDL.h>
+
+//Overlay of the phase timings and input latencies (PhaseTimer.h), toggled with F3. Every printable ASCII glyph is rasterized into
+//one texture up front, so drawing is a few fills and copies out of it, with nothing allocated per frame.
+class Hud
+{
+public:
+	Hud(SDL_Renderer* renderer);
+	Hud(const Hud&) = delete;
+	Hud& operator=(const Hud&) = delete;
+	~Hud();
+
+	void toggle();
+	bool isVisible();
+	//Draws over the frame rendered so far, when visible.
+	void draw();
+
+private:
+	//Draws text at x, y out of the glyph texture. Returns the x after it.
+	int drawText(const char* text, int x, int y);
+	//One summary's count and percentiles in ms, at the given column offsets from x.
+	void drawRow(const char* name, const PhaseSummary& summary, int x, int y, const int* columns);
+
+	static const int FIRST_GLYPH = 32;
+	static const int GLYPH_COUNT = 95;
+
+	SDL_Renderer* ren;
+	SDL_Texture* glyphTex;
+	SDL_Rect glyphs[GLYPH_COUNT];
+	int advances[GLYPH_COUNT];
+	int lineHeight;
+	bool visible;
+};
@@ -0,0 +1,107 @@
+#include "ImageDecoder.h"
+#include <iostream>
+#include <cstdio>
+#include <csetjmp>
+#include <cstring>
+#include <SDL2/SDL_image.h>
+#include <jpeglib.h>
+
+//libjpeg reports fatal errors through error_exit, which must not return. Jump back to decodeJpeg instead.
+struct JpegErrorManager {
+	jpeg_error_mgr pub;
+	jmp_buf jump;
+};
+
+static void jpegErrorExit(j_common_ptr cinfo) {
+	JpegErrorManager* err = (JpegErrorManager*)cinfo->err;
+	char message[JMSG_LENGTH_MAX];
+	(*cinfo->err->format_message)(cinfo, message);
+	std::cout << "jpeg decode error: " << message << std::endl;
+	longjmp(err->jump, 1);
+}
+
+static bool isJpeg(FILE* file) {
+	unsigned char magic[2];
+	bool jpeg = fread(magic, 1, 2, file) == 2 && magic[0] == 0xFF && magic[1] == 0xD8;
+	rewind(file);
+	return jpeg;
+}
+
+static bool decodeJpeg(FILE* file, PixelBuffer* buffer, const std::atomic<bool>* wanted) {
+	jpeg_decompress_struct cinfo;
+	JpegErrorManager err;
+	cinfo.err = jpeg_std_error(&err.pub);
+	err.pub.error_exit = jpegErrorExit;
+	if (setjmp(err.jump)) {
+		jpeg_destroy_decompress(&cinfo);
+		return false;
+	}
+	jpeg_create_decompress(&cinfo);
+	jpeg_stdio_src(&cinfo, file);
+	jpeg_read_header(&cinfo, TRUE);
+	//libjpeg-turbo extension, writes R,G,B,0xFF bytes which matches SDL_PIXELFORMAT_RGBA32
+	cinfo.out_color_space = JCS_EXT_RGBA;
+	jpeg_start_decompress(&cinfo);
+
+	buffer->w = cinfo.output_width;
+	buffer->h = cinfo.output_height;
+	buffer->pitch = buffer->w * 4;
+	//resize only allocates when the buffer has never held an image this large
+	buffer->pixels.resize((size_t)buffer->pitch * buffer->h);
+
+	while (cinfo.output_scanline < cinfo.output_height) {
+		if (wanted && !*wanted) {
+			//destroy also aborts the decompression in progress
+			jpeg_destroy_decompress(&cinfo);
+			return false;
+		}
+		JSAMPROW row = &buffer->pixels[(size_t)cinfo.output_scanline * buffer->pitch];
+		jpeg_read_scanlines(&cinfo, &row, 1);
+	}
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
+	return true;
+}
+
+static bool decodeOther(std::string filename, PixelBuffer* buffer) {
+	SDL_Surface* loaded = IMG_Load(filename.c_str());
+	if (loaded == nullptr) {
+		std::cout << "IMG_Load Error: " << IMG_GetError() << std::endl;
+		return false;
+	}
+	SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(loaded);
+	if (rgba == nullptr) {
+		std::cout << "SDL_ConvertSurfaceFormat Error: " << SDL_GetError() << std::endl;
+		return false;
+	}
+	buffer->w = rgba->w;
+	buffer->h = rgba->h;
+	buffer->pitch = rgba->w * 4;
+	buffer->pixels.resize((size_t)buffer->pitch * buffer->h);
+	SDL_LockSurface(rgba);
+	for (int y = 0; y < rgba->h; y++) {
+		memcpy(&buffer->pixels[(size_t)y * buffer->pitch], (Uint8*)rgba->pixels + y * rgba->pitch, buffer->pitch);
+	}
+	SDL_UnlockSurface(rgba);
+	SDL_FreeSurface(rgba);
+	return true;
+}
+
+bool decodeImage(std::string filename, PixelBuffer* buffer, const std::atomic<bool>* wanted) {
+	if (wanted && !*wanted) {
+		return false;
+	}
+	FILE* file = fopen(filename.c_str(), "rb");
+	if (!file) {
+		std::cout << "Error opening image " << filename << std::endl;
+		return false;
+	}
+	if (!isJpeg(file)) {
+		fclose(file);
+		return decodeOther(filename, buffer);
+	}
+	bool decoded = decodeJpeg(file, buffer, wanted);
+	fclose(file);
+	return decoded;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include "TexturePool.h"
+
+//Decodes an image file into buffer as packed RGBA. JPEGs are decoded with libjpeg straight into the buffer,
+//anything else goes through SDL_image. The buffer's memory is reused when it is already large enough.
+//If wanted is given, a JPEG decode stops at the next scanline once it goes false and false is returned.
+bool decodeImage(std::string filename, PixelBuffer* buffer, const std::atomic<bool>* wanted = nullptr);
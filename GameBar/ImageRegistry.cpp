@@ -0,0 +1,601 @@
+#include "ImageRegistry.h"
+#include "Constants.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <set>
+
+ImageRegistry::ImageRegistry(TexturePool* pool, AssetLoader* assetLoader) {
+	texPool = pool;
+	loader = assetLoader;
+	downloads = decodes = cancels = 0;
+	diskHits = diskMisses = 0;
+	trimmed = false;
+	//listed once, registering an image looks it up here rather than probing the disk
+	std::error_code error;
+	for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(cacheDir, error)) {
+		std::string name = entry.path().filename().string();
+		if (name.compare(0, 3, "img") == 0 && entry.path().extension() != ".part") {
+			cachedFiles.insert(name);
+		}
+	}
+}
+
+ImageRegistry::~ImageRegistry() {
+	for (Image& image : images) {
+		if (image.tex) {
+			texPool->releaseTexture(image.tex);
+		}
+	}
+}
+
+//FNV-1a, hex
+static std::string urlHash(const std::string& url) {
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : url) {
+		hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+	}
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+	return hex;
+}
+
+//cached file of url, in cacheDir
+static std::string cacheName(const std::string& url) {
+	return "img" + urlHash(url) + ".jpg";
+}
+
+void ImageRegistry::trimCache(uintmax_t maxBytes) {
+	namespace fs = std::filesystem;
+	//files an image is using or fetching stay, whatever their age
+	std::set<std::string> busy;
+	std::map<std::string, int> registered;
+	for (int id = 0; id < (int)images.size(); id++) {
+		Image& image = images[id];
+		if (image.url.empty()) continue;
+		std::string name = cacheName(image.url);
+		registered[name] = id;
+		if (image.fileRefs > 0 || !image.tickets.empty()) {
+			busy.insert(name);
+		}
+	}
+	std::vector<std::pair<fs::file_time_type, fs::path>> files;
+	uintmax_t total = 0;
+	std::error_code error;
+	cachedFiles.clear();
+	for (const fs::directory_entry& entry : fs::directory_iterator(cacheDir, error)) {
+		std::string name = entry.path().filename().string();
+		if (name.compare(0, 3, "img") != 0) continue;
+		//downloads cut off by the last exit, or called off since
+		if (entry.path().extension() == ".part") {
+			if (!busy.count(entry.path().stem().string())) {
+				fs::remove(entry.path(), error);
+			}
+			continue;
+		}
+		uintmax_t bytes = entry.file_size(error);
+		if (error) continue;
+		total += bytes;
+		cachedFiles.insert(name);
+		if (!busy.count(name)) {
+			files.push_back(std::make_pair(entry.last_write_time(error), entry.path()));
+		}
+	}
+	std::sort(files.begin(), files.end());
+	int removed = 0;
+	for (size_t i = 0; i < files.size() && total > maxBytes; i++) {
+		uintmax_t bytes = fs::file_size(files[i].second, error);
+		if (!error && fs::remove(files[i].second, error)) {
+			total -= bytes;
+			removed++;
+			std::string name = files[i].second.filename().string();
+			cachedFiles.erase(name);
+			//a registered image nobody holds, fetched again if it is wanted
+			auto image = registered.find(name);
+			if (image != registered.end()) {
+				images[image->second].onDisk = false;
+			}
+		}
+	}
+	if (!trimmed || removed > 0) {
+		std::cout << "Image cache: " << cachedFiles.size() << " files, " << total / 1024 << " KB";
+		if (removed > 0) {
+			std::cout << ", " << removed << " oldest removed";
+		}
+		std::cout << std::endl;
+	}
+	trimmed = true;
+}
+
+int ImageRegistry::registerImage(std::string url) {
+	auto existing = idsByUrl.find(url);
+	if (existing != idsByUrl.end()) {
+		images[existing->second].users++;
+		return existing->second;
+	}
+	int id;
+	if (!freeIds.empty()) {
+		id = freeIds.back();
+		freeIds.pop_back();
+	}
+	else {
+		id = (int)images.size();
+		images.emplace_back();
+	}
+	Image& image = images[id];
+	image.url = url;
+	//file names come from a hash of the url, urls can't be used as paths. The same image gets the same file
+	//on the next run, so one downloaded before is already on disk
+	std::string name = cacheName(url);
+	image.filename = cacheDir + "/" + name;
+	image.tex = nullptr;
+	image.fileRefs = image.texRefs = 0;
+	image.users = 1;
+	image.decoding = false;
+	image.traceFlow = 0;
+	image.failures = 0;
+	image.failedAt = 0;
+	image.onDisk = cachedFiles.count(name) > 0;
+	idsByUrl[url] = id;
+	return id;
+}
+
+void ImageRegistry::unregisterImage(int id) {
+	if (id < 0 || images[id].users == 0) return;
+	images[id].users--;
+	recycleIfUnused(id);
+}
+
+void ImageRegistry::recycleIfUnused(int id) {
+	Image& image = images[id];
+	if (image.users > 0 || image.fileRefs > 0 || image.texRefs > 0 || image.tex ||
+		!image.tickets.empty() || !image.loads.empty() || image.url.empty()) {
+		return;
+	}
+	idsByUrl.erase(image.url);
+	image.url.clear();
+	freeIds.push_back(id);
+}
+
+ImageFileRef ImageRegistry::acquireFile(int id, JobPriority priority) {
+	retainFile(id, priority);
+	return ImageFileRef(this, id);
+}
+
+ImageTextureRef ImageRegistry::acquireTexture(int id, JobPriority priority) {
+	retainTexture(id, priority);
+	return ImageTextureRef(this, id);
+}
+
+LoadHandle ImageRegistry::requestFile(int id, JobPriority priority) {
+	ImageFileRef file = acquireFile(id, priority);
+	auto load = std::make_shared<ImageLoad>();
+	load->imageId = id;
+	load->texture = false;
+	if (images[id].onDisk) {
+		load->status = LOAD_DONE;
+	}
+	else {
+		images[id].loads.push_back(load);
+	}
+	return LoadHandle(this, std::move(file), load);
+}
+
+LoadHandle ImageRegistry::requestTexture(int id, JobPriority priority) {
+	ImageTextureRef texture = acquireTexture(id, priority);
+	auto load = std::make_shared<ImageLoad>();
+	load->imageId = id;
+	load->texture = true;
+	if (images[id].tex) {
+		load->status = LOAD_DONE;
+	}
+	else {
+		images[id].loads.push_back(load);
+	}
+	return LoadHandle(this, std::move(texture), load);
+}
+
+void ImageRegistry::retainFile(int id, JobPriority priority) {
+	Image& image = images[id];
+	image.fileRefs++;
+	if (!image.onDisk && image.tickets.empty()) {
+		diskMisses++;
+		diskCacheMisses.add();
+		request(id, false, priority);
+	}
+	updateTickets(image);
+}
+
+void ImageRegistry::releaseFile(int id) {
+	Image& image = images[id];
+	if (image.fileRefs == 0) return;
+	image.fileRefs--;
+	updateTickets(image);
+	recycleIfUnused(id);
+}
+
+void ImageRegistry::retainTexture(int id, JobPriority priority) {
+	Image& image = images[id];
+	image.texRefs++;
+	image.fileRefs++;
+	if (!image.tex && !image.decoding) {
+		(image.onDisk ? diskHits : diskMisses)++;
+		(image.onDisk ? diskCacheHits : diskCacheMisses).add();
+		request(id, true, priority);
+	}
+	updateTickets(image);
+}
+
+void ImageRegistry::releaseTexture(int id) {
+	Image& image = images[id];
+	if (image.texRefs == 0) return;
+	image.texRefs--;
+	if (image.texRefs == 0 && image.tex) {
+		texPool->releaseTexture(image.tex);
+		image.tex = nullptr;
+	}
+	releaseFile(id);
+}
+
+void ImageRegistry::update() {
+	//retry anything that didn't fit in the loader's queue last time
+	while (!backlog.empty() && loader->post(backlog.front())) {
+		backlog.pop_front();
+	}
+
+	AssetResult result;
+	while (loader->poll(&result)) {
+		Image& image = images[result.imageId];
+		image.tickets.erase(std::remove(image.tickets.begin(), image.tickets.end(), result.ticket), image.tickets.end());
+		if (result.onDisk && !image.onDisk) {
+			downloads++;
+			cachedFiles.insert(cacheName(image.url));
+		}
+		//a cancelled download says nothing about the file
+		if (result.onDisk || !result.cancelled) {
+			image.onDisk = result.onDisk;
+		}
+		if (result.cancelled) {
+			cancels++;
+		}
+		if (result.decodeRequested) {
+			image.decoding = false;
+			for (auto& ticket : image.tickets) {
+				image.decoding = image.decoding || ticket->decode;
+			}
+			if (result.pixels == nullptr) {
+				if (!result.cancelled) {
+					std::cout << "image " << image.filename << " failed to load" << std::endl;
+				}
+			}
+			//the texture may have been released while the loader was busy
+			else if (image.texRefs > 0 && !image.tex) {
+				Uint64 start = SDL_GetPerformanceCounter();
+				image.tex = texPool->uploadTexture(result.pixels);
+				decodes++;
+				traceSpan("asset", "upload", start, SDL_GetPerformanceCounter(), result.traceFlow);
+				image.traceFlow = result.traceFlow;
+			}
+			if (result.pixels) {
+				loader->recycle(result.pixels);
+			}
+		}
+		//called off, then wanted again before the result came back
+		if (result.cancelled) {
+			if (image.texRefs > 0 && !image.tex && !image.decoding) {
+				request(result.imageId, true, JOB_PRIORITY_NORMAL);
+			}
+			else if (image.fileRefs > 0 && !image.onDisk && image.tickets.empty()) {
+				request(result.imageId, false, JOB_PRIORITY_LOW);
+			}
+		}
+		resolveLoads(image);
+		recycleIfUnused(result.imageId);
+	}
+}
+
+void ImageRegistry::request(int id, bool decode, JobPriority priority) {
+	Image& image = images[id];
+	AssetRequest request;
+	request.imageId = id;
+	request.url = image.url;
+	request.filename = image.filename;
+	request.decode = decode;
+	request.priority = priority;
+	request.ticket = std::make_shared<AssetTicket>();
+	request.ticket->decode = decode;
+	request.traceFlow = newTraceFlow();
+	if (request.traceFlow != 0) {
+		Uint64 now = SDL_GetPerformanceCounter();
+		traceSpan("asset", decode ? "queued for texture" : "queued for file", now, now, request.traceFlow, TRACE_FLOW_START);
+	}
+	image.tickets.push_back(request.ticket);
+	if (decode) {
+		image.decoding = true;
+	}
+	if (!backlog.empty() || !loader->post(request)) {
+		backlog.push_back(request);
+	}
+}
+
+void ImageRegistry::updateTickets(Image& image) {
+	for (auto& ticket : image.tickets) {
+		ticket->wantFile = image.fileRefs > 0;
+		ticket->wantPixels = image.texRefs > 0;
+	}
+}
+
+void ImageRegistry::resolveLoads(Image& image) {
+	//collect first, callbacks may request or cancel loads on this image
+	std::vector<std::pair<std::shared_ptr<ImageLoad>, LoadStatus>> finished;
+	for (auto it = image.loads.begin(); it != image.loads.end();) {
+		LoadStatus status = LOAD_PENDING;
+		if ((*it)->texture) {
+			if (image.tex) status = LOAD_DONE;
+			else if (!image.decoding) status = LOAD_FAILED;
+		}
+		else {
+			if (image.onDisk) status = LOAD_DONE;
+			else if (image.tickets.empty()) status = LOAD_FAILED;
+		}
+		if (status == LOAD_PENDING) {
+			++it;
+		}
+		else {
+			finished.push_back(std::make_pair(*it, status));
+			it = image.loads.erase(it);
+		}
+	}
+	//loads failing together are one failure
+	bool failed = false;
+	for (auto& entry : finished) {
+		failed = failed || entry.second == LOAD_FAILED;
+		if (entry.second == LOAD_DONE) {
+			image.failures = 0;
+		}
+	}
+	if (failed) {
+		image.failures++;
+		image.failedAt = SDL_GetTicks();
+	}
+	for (auto& entry : finished) {
+		entry.first->status = entry.second;
+		for (auto& callback : entry.first->callbacks) {
+			callback(entry.second);
+		}
+		entry.first->callbacks.clear();
+	}
+}
+
+void ImageRegistry::finishLoad(std::shared_ptr<ImageLoad> load, LoadStatus status) {
+	std::vector<std::shared_ptr<ImageLoad>>& loads = images[load->imageId].loads;
+	loads.erase(std::remove(loads.begin(), loads.end(), load), loads.end());
+	load->status = status;
+	for (auto& callback : load->callbacks) {
+		callback(status);
+	}
+	load->callbacks.clear();
+}
+
+bool ImageRegistry::isOnDisk(int id) {
+	return images[id].onDisk;
+}
+
+SDL_Texture* ImageRegistry::getTexture(int id) {
+	return images[id].tex;
+}
+
+std::string ImageRegistry::getUrl(int id) {
+	return images[id].url;
+}
+
+std::string ImageRegistry::getFilename(int id) {
+	return images[id].filename;
+}
+
+int ImageRegistry::getDownloadCount() {
+	return downloads;
+}
+
+int ImageRegistry::getDecodeCount() {
+	return decodes;
+}
+
+int ImageRegistry::getDiskHitCount() {
+	return diskHits;
+}
+
+int ImageRegistry::getDiskMissCount() {
+	return diskMisses;
+}
+
+bool ImageRegistry::isRetryDue(int id, Uint32 now) {
+	Image& image = images[id];
+	if (image.failures == 0) return true;
+	Uint32 wait = std::min(IMAGE_MAX_RETRY_MS, IMAGE_RETRY_MS << std::min(image.failures - 1, 5));
+	return now - image.failedAt >= wait;
+}
+
+void ImageRegistry::notePresented(int id) {
+	Image& image = images[id];
+	if (image.traceFlow == 0) return;
+	Uint64 now = SDL_GetPerformanceCounter();
+	traceSpan("asset", "first presented", now, now, image.traceFlow, TRACE_FLOW_END);
+	image.traceFlow = 0;
+}
+
+int ImageRegistry::getCancelCount() {
+	return cancels;
+}
+
+ImageFileRef::ImageFileRef() {
+	images = nullptr;
+	imageId = -1;
+}
+
+ImageFileRef::ImageFileRef(ImageRegistry* registry, int id) {
+	images = registry;
+	imageId = id;
+}
+
+ImageFileRef::ImageFileRef(ImageFileRef&& other) noexcept {
+	images = other.images;
+	imageId = other.imageId;
+	other.images = nullptr;
+	other.imageId = -1;
+}
+
+ImageFileRef& ImageFileRef::operator=(ImageFileRef&& other) noexcept {
+	if (this != &other) {
+		reset();
+		images = other.images;
+		imageId = other.imageId;
+		other.images = nullptr;
+		other.imageId = -1;
+	}
+	return *this;
+}
+
+ImageFileRef::~ImageFileRef() {
+	reset();
+}
+
+void ImageFileRef::reset() {
+	if (images) {
+		images->releaseFile(imageId);
+		images = nullptr;
+		imageId = -1;
+	}
+}
+
+bool ImageFileRef::valid() const {
+	return images != nullptr;
+}
+
+ImageTextureRef::ImageTextureRef() {
+	images = nullptr;
+	imageId = -1;
+}
+
+ImageTextureRef::ImageTextureRef(ImageRegistry* registry, int id) {
+	images = registry;
+	imageId = id;
+}
+
+ImageTextureRef::ImageTextureRef(ImageTextureRef&& other) noexcept {
+	images = other.images;
+	imageId = other.imageId;
+	other.images = nullptr;
+	other.imageId = -1;
+}
+
+ImageTextureRef& ImageTextureRef::operator=(ImageTextureRef&& other) noexcept {
+	if (this != &other) {
+		reset();
+		images = other.images;
+		imageId = other.imageId;
+		other.images = nullptr;
+		other.imageId = -1;
+	}
+	return *this;
+}
+
+ImageTextureRef::~ImageTextureRef() {
+	reset();
+}
+
+void ImageTextureRef::reset() {
+	if (images) {
+		images->releaseTexture(imageId);
+		images = nullptr;
+		imageId = -1;
+	}
+}
+
+bool ImageTextureRef::valid() const {
+	return images != nullptr;
+}
+
+SDL_Texture* ImageTextureRef::get() const {
+	if (!images) return nullptr;
+	return images->getTexture(imageId);
+}
+
+LoadHandle::LoadHandle() {
+	images = nullptr;
+}
+
+LoadHandle::LoadHandle(ImageRegistry* registry, ImageFileRef fileRef, std::shared_ptr<ImageLoad> imageLoad) {
+	images = registry;
+	file = std::move(fileRef);
+	load = std::move(imageLoad);
+}
+
+LoadHandle::LoadHandle(ImageRegistry* registry, ImageTextureRef textureRef, std::shared_ptr<ImageLoad> imageLoad) {
+	images = registry;
+	texture = std::move(textureRef);
+	load = std::move(imageLoad);
+}
+
+LoadHandle::LoadHandle(LoadHandle&& other) noexcept {
+	images = other.images;
+	file = std::move(other.file);
+	texture = std::move(other.texture);
+	load = std::move(other.load);
+	other.images = nullptr;
+}
+
+LoadHandle& LoadHandle::operator=(LoadHandle&& other) noexcept {
+	if (this != &other) {
+		cancel();
+		images = other.images;
+		file = std::move(other.file);
+		texture = std::move(other.texture);
+		load = std::move(other.load);
+		other.images = nullptr;
+	}
+	return *this;
+}
+
+LoadHandle::~LoadHandle() {
+	cancel();
+}
+
+void LoadHandle::cancel() {
+	if (!load) return;
+	if (load->status == LOAD_PENDING) {
+		images->finishLoad(load, LOAD_CANCELLED);
+	}
+	//releasing the last reference is what calls off the loader's work
+	file.reset();
+	texture.reset();
+	load.reset();
+	images = nullptr;
+}
+
+void LoadHandle::onComplete(std::function<void(LoadStatus)> callback) {
+	if (!load) {
+		callback(LOAD_CANCELLED);
+	}
+	else if (load->status != LOAD_PENDING) {
+		callback(load->status);
+	}
+	else {
+		load->callbacks.push_back(std::move(callback));
+	}
+}
+
+LoadStatus LoadHandle::getStatus() const {
+	return load ? load->status : LOAD_CANCELLED;
+}
+
+bool LoadHandle::valid() const {
+	return load != nullptr;
+}
+
+SDL_Texture* LoadHandle::getTexture() const {
+	return texture.get();
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "AssetLoader.h"
+#include "TexturePool.h"
+
+class ImageRegistry;
+
+//Move-only owner of one reference to a registered image's cached file. Released on destruction.
+class ImageFileRef
+{
+public:
+	ImageFileRef();
+	ImageFileRef(ImageRegistry* registry, int id);
+	ImageFileRef(ImageFileRef&& other) noexcept;
+	ImageFileRef& operator=(ImageFileRef&& other) noexcept;
+	ImageFileRef(const ImageFileRef&) = delete;
+	ImageFileRef& operator=(const ImageFileRef&) = delete;
+	~ImageFileRef();
+
+	//Drops the reference early.
+	void reset();
+	bool valid() const;
+
+private:
+	ImageRegistry* images;
+	int imageId;
+};
+
+//Move-only owner of one reference to a registered image's texture. Released on destruction.
+//get() is null until the loader thread has delivered the pixels.
+class ImageTextureRef
+{
+public:
+	ImageTextureRef();
+	ImageTextureRef(ImageRegistry* registry, int id);
+	ImageTextureRef(ImageTextureRef&& other) noexcept;
+	ImageTextureRef& operator=(ImageTextureRef&& other) noexcept;
+	ImageTextureRef(const ImageTextureRef&) = delete;
+	ImageTextureRef& operator=(const ImageTextureRef&) = delete;
+	~ImageTextureRef();
+
+	//Drops the reference early.
+	void reset();
+	bool valid() const;
+	SDL_Texture* get() const;
+
+private:
+	ImageRegistry* images;
+	int imageId;
+};
+
+enum LoadStatus {
+	LOAD_PENDING,
+	LOAD_DONE,
+	LOAD_FAILED,
+	LOAD_CANCELLED
+};
+
+//State of one requested load, shared by its LoadHandle and the registry until it finishes.
+struct ImageLoad {
+	int imageId = -1;
+	//waiting on the texture rather than just the file
+	bool texture = false;
+	LoadStatus status = LOAD_PENDING;
+	std::vector<std::function<void(LoadStatus)>> callbacks;
+};
+
+//Move-only handle to an asynchronous image load, from ImageRegistry::requestFile/requestTexture. Holds a file or
+//texture reference for as long as it lives. Cancelling or destroying it before it finishes calls the work off,
+//unless another handle still needs the same image. UI thread only, callbacks included.
+class LoadHandle
+{
+public:
+	LoadHandle();
+	LoadHandle(ImageRegistry* registry, ImageFileRef file, std::shared_ptr<ImageLoad> load);
+	LoadHandle(ImageRegistry* registry, ImageTextureRef texture, std::shared_ptr<ImageLoad> load);
+	LoadHandle(LoadHandle&& other) noexcept;
+	LoadHandle& operator=(LoadHandle&& other) noexcept;
+	LoadHandle(const LoadHandle&) = delete;
+	LoadHandle& operator=(const LoadHandle&) = delete;
+	~LoadHandle();
+
+	//Drops the handle's reference. A pending load finishes as LOAD_CANCELLED, running its callbacks.
+	void cancel();
+
+	//Runs callback when the load finishes, or straight away if it already has.
+	void onComplete(std::function<void(LoadStatus)> callback);
+
+	//LOAD_CANCELLED once the handle is empty
+	LoadStatus getStatus() const;
+	bool valid() const;
+	//nullptr unless this is a finished texture load
+	SDL_Texture* getTexture() const;
+
+private:
+	ImageRegistry* images;
+	ImageFileRef file;
+	ImageTextureRef texture;
+	std::shared_ptr<ImageLoad> load;
+};
+
+//Hands out shared, reference counted images keyed by URL. However many games point at the same URL,
+//it is downloaded once, decoded once and uploaded once. Files and textures are counted separately so a
+//game can keep an image on disk without holding its texture. Downloads and decodes are handed to the
+//AssetLoader; update() collects what it finished. Work nobody needs any more is called off through the
+//request's AssetTicket. Everything here runs on the UI thread.
+class ImageRegistry
+{
+public:
+	ImageRegistry(TexturePool* pool, AssetLoader* assetLoader);
+
+	//Releases all textures regardless of outstanding references. Cached files stay for the next run.
+	//The loader must already be stopped.
+	~ImageRegistry();
+
+	//Returns the id for url, registering it on first use. Each call counts as one user of the id.
+	int registerImage(std::string url);
+
+	//Drops one user of id. An image with no users and nothing loaded or in flight is forgotten and its
+	//id reused, so the registry only grows with the games currently held.
+	void unregisterImage(int id);
+
+	//Returns an owning reference to the cached file, queueing the download if this is the first one.
+	ImageFileRef acquireFile(int id, JobPriority priority = JOB_PRIORITY_LOW);
+
+	//Returns an owning reference to the texture, queueing the download and decode if this is the first one.
+	ImageTextureRef acquireTexture(int id, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+	//Like acquireFile, but the returned handle also reports when the file is on disk.
+	LoadHandle requestFile(int id, JobPriority priority);
+
+	//Like acquireTexture, but the returned handle also reports when the texture is ready.
+	LoadHandle requestTexture(int id, JobPriority priority);
+
+	//Takes a reference on the cached file, queueing the download if this is the first one.
+	void retainFile(int id, JobPriority priority = JOB_PRIORITY_LOW);
+
+	//Drops a file reference. The file itself stays on disk, see trimCache().
+	void releaseFile(int id);
+
+	//Takes a reference on the texture, queueing the download and decode if this is the first one. Also retains the file.
+	void retainTexture(int id, JobPriority priority = JOB_PRIORITY_NORMAL);
+
+	//Drops a texture reference. The texture goes back to the pool when the last one goes. Also releases the file.
+	void releaseTexture(int id);
+
+	//Uploads decoded images and records finished downloads. Call once per frame.
+	void update();
+
+	bool isOnDisk(int id);
+	//nullptr until the decoded image has been uploaded
+	SDL_Texture* getTexture(int id);
+	std::string getUrl(int id);
+	std::string getFilename(int id);
+
+	int getDownloadCount();
+	int getDecodeCount();
+	//loads that found their file already on disk, and those that had to download it
+	int getDiskHitCount();
+	int getDiskMissCount();
+
+	//Whether an image whose last load failed has waited out its backoff: IMAGE_RETRY_MS, doubled for each failure
+	//in a row up to IMAGE_MAX_RETRY_MS. True for an image that hasn't failed.
+	bool isRetryDue(int id, Uint32 now);
+
+	//Marks the texture of id as drawn, ending its trace flow the first time. Call when rendering it.
+	void notePresented(int id);
+	//requests called off before they finished
+	int getCancelCount();
+
+	//Deletes the oldest image files in cacheDir until the rest fit in maxBytes, and partial downloads, skipping any
+	//an image holds or is fetching. Image files persist between runs, so this is what bounds the cache; it walks
+	//the directory, so call it at startup and then every IMAGE_CACHE_TRIM_MS or so.
+	void trimCache(uintmax_t maxBytes);
+
+private:
+	friend class LoadHandle;
+
+	struct Image {
+		std::string url;
+		std::string filename;
+		SDL_Texture* tex;
+		int fileRefs;
+		int texRefs;
+		//registerImage() calls not yet matched by unregisterImage()
+		int users;
+		bool onDisk;
+		//a request with decode set is with the loader
+		bool decoding;
+		//requests with the loader, empty when it has nothing for this image
+		std::vector<std::shared_ptr<AssetTicket>> tickets;
+		//pending loads waiting on this image
+		std::vector<std::shared_ptr<ImageLoad>> loads;
+		//trace flow of the request whose texture hasn't been drawn yet, 0 if none (see Trace.h)
+		Uint64 traceFlow;
+		//loads failed in a row, and when the last did
+		int failures;
+		Uint32 failedAt;
+	};
+
+	//Sends image's work to the loader, or to the backlog if its queue is full.
+	void request(int id, bool decode, JobPriority priority);
+	//Tells image's in flight requests which of their work is still wanted.
+	void updateTickets(Image& image);
+	//Finishes image's pending loads that are done or can no longer finish.
+	void resolveLoads(Image& image);
+	//Finishes one load, running its callbacks.
+	void finishLoad(std::shared_ptr<ImageLoad> load, LoadStatus status);
+	//Frees id for reuse if it has no users left and nothing loaded or in flight.
+	void recycleIfUnused(int id);
+
+	TexturePool* texPool;
+	AssetLoader* loader;
+	std::vector<Image> images;
+	//requests that didn't fit in the loader's queue, oldest first
+	std::deque<AssetRequest> backlog;
+	std::map<std::string, int> idsByUrl;
+	std::vector<int> freeIds;
+	int downloads;
+	int decodes;
+	int cancels;
+	int diskHits;
+	int diskMisses;
+	//names of the image files in cacheDir, listed when the registry is made and kept up to date since
+	std::set<std::string> cachedFiles;
+	//trimCache() has run, later runs only report when they remove something
+	bool trimmed;
+};
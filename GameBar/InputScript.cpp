@@ -0,0 +1,157 @@
+#include "InputScript.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+//a held key repeats about this often, as a keyboard's auto-repeat does
+static const Uint32 HOLD_REPEAT_MS = 33;
+
+static SDL_Event keyEvent(SDL_Scancode scancode, bool repeat) {
+	SDL_Event e;
+	SDL_zero(e);
+	e.type = SDL_KEYDOWN;
+	e.key.state = SDL_PRESSED;
+	e.key.repeat = repeat;
+	e.key.keysym.scancode = scancode;
+	e.key.keysym.sym = SDL_GetKeyFromScancode(scancode);
+	return e;
+}
+
+InputScript::InputScript() {
+	next = 0;
+	recording = nullptr;
+}
+
+InputScript::~InputScript() {
+	if (recording) {
+		fclose(recording);
+	}
+}
+
+bool InputScript::load(const std::string& path) {
+	std::ifstream file(path);
+	if (!file) {
+		std::cout << "Error opening file " << path << "!" << std::endl;
+		return false;
+	}
+	events.clear();
+	next = 0;
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		size_t start = line.find_first_not_of(" \t\r");
+		if (start == std::string::npos || line[start] == '#') continue;
+		std::istringstream fields(line);
+		Uint32 at = 0;
+		std::string action, rest;
+		bool valid = (bool)(fields >> at >> action);
+		std::getline(fields >> std::ws, rest);
+		rest.erase(rest.find_last_not_of(" \t\r") + 1);
+
+		ScriptEvent scripted;
+		scripted.at = at;
+		SDL_zero(scripted.event);
+		if (valid && action == "hold") {
+			//scancode names can have spaces, "Keypad 4", so the duration is split off the end
+			size_t split = rest.find_last_of(" \t");
+			SDL_Scancode scancode = split == std::string::npos ? SDL_SCANCODE_UNKNOWN : SDL_GetScancodeFromName(rest.substr(0, split).c_str());
+			Uint32 holdMs = split == std::string::npos ? 0 : (Uint32)atoi(rest.c_str() + split + 1);
+			valid = scancode != SDL_SCANCODE_UNKNOWN;
+			for (Uint32 held = 0; valid && held <= holdMs; held += HOLD_REPEAT_MS) {
+				scripted.at = at + held;
+				scripted.event = keyEvent(scancode, held > 0);
+				events.push_back(scripted);
+			}
+			continue;
+		}
+		if (valid && action == "key") {
+			SDL_Scancode scancode = SDL_GetScancodeFromName(rest.c_str());
+			valid = scancode != SDL_SCANCODE_UNKNOWN;
+			scripted.event = keyEvent(scancode, false);
+		}
+		else if (valid && action == "button") {
+			scripted.event.type = SDL_CONTROLLERBUTTONDOWN;
+			scripted.event.cbutton.state = SDL_PRESSED;
+			scripted.event.cbutton.button = (Uint8)SDL_GameControllerGetButtonFromString(rest.c_str());
+			valid = SDL_GameControllerGetButtonFromString(rest.c_str()) != SDL_CONTROLLER_BUTTON_INVALID;
+		}
+		else if (valid && action == "axis") {
+			std::istringstream axisFields(rest);
+			std::string axis;
+			int value = 0;
+			axisFields >> axis >> value;
+			scripted.event.type = SDL_CONTROLLERAXISMOTION;
+			scripted.event.caxis.axis = (Uint8)SDL_GameControllerGetAxisFromString(axis.c_str());
+			scripted.event.caxis.value = (Sint16)std::max(-32768, std::min(32767, value));
+			valid = !axisFields.fail() && SDL_GameControllerGetAxisFromString(axis.c_str()) != SDL_CONTROLLER_AXIS_INVALID;
+		}
+		else if (valid && action == "quit") {
+			scripted.event.type = SDL_QUIT;
+		}
+		else {
+			valid = false;
+		}
+		if (!valid) {
+			std::cout << path << ":" << lineNumber << ": can't parse \"" << line << "\"" << std::endl;
+			return false;
+		}
+		events.push_back(scripted);
+	}
+	//holds overlap whatever comes after them; equal times keep the file's order
+	std::stable_sort(events.begin(), events.end(), [](const ScriptEvent& a, const ScriptEvent& b) {
+		return a.at < b.at;
+	});
+	return true;
+}
+
+void InputScript::inject(Uint32 elapsed) {
+	while (next < events.size() && events[next].at <= elapsed) {
+		SDL_Event e = events[next++].event;
+		e.common.timestamp = SDL_GetTicks();
+		SDL_PushEvent(&e);
+	}
+}
+
+bool InputScript::isFinished() {
+	return next >= events.size();
+}
+
+bool InputScript::startRecording(const std::string& path) {
+	recording = fopen(path.c_str(), "w");
+	if (!recording) {
+		std::cout << "Error opening file " << path << "!" << std::endl;
+		return false;
+	}
+	fprintf(recording, "#ms action, recorded by GameBar --record-input\n");
+	return true;
+}
+
+void InputScript::record(const SDL_Event& e, Uint32 elapsed) {
+	if (!recording) return;
+	switch (e.type) {
+	case SDL_KEYDOWN:
+		//keys SDL has no name for couldn't be replayed, and the carousel ignores them anyway
+		if (*SDL_GetScancodeName(e.key.keysym.scancode)) {
+			fprintf(recording, "%u key %s\n", elapsed, SDL_GetScancodeName(e.key.keysym.scancode));
+		}
+		break;
+	case SDL_CONTROLLERBUTTONDOWN:
+		if (const char* button = SDL_GameControllerGetStringForButton((SDL_GameControllerButton)e.cbutton.button)) {
+			fprintf(recording, "%u button %s\n", elapsed, button);
+		}
+		break;
+	case SDL_CONTROLLERAXISMOTION:
+		if (const char* axis = SDL_GameControllerGetStringForAxis((SDL_GameControllerAxis)e.caxis.axis)) {
+			fprintf(recording, "%u axis %s %d\n", elapsed, axis, e.caxis.value);
+		}
+		break;
+	case SDL_QUIT:
+		fprintf(recording, "%u quit\n", elapsed);
+		break;
+	default:
+		break;
+	}
+}
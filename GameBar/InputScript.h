@@ -0,0 +1,43 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//Timeline of input, recorded from a session or written by hand, one event per line:
+//  <ms> key <scancode name>              a key press, e.g. "1500 key Right" or "4000 key PageDown"
+//  <ms> hold <scancode name> <for ms>    presses repeated as a held key repeats, e.g. "0 hold Right 3000"
+//  <ms> button <controller button>       e.g. "dpleft", as SDL_GameControllerGetButtonFromString() names them
+//  <ms> axis <controller axis> <value>   e.g. "leftx 32767"
+//  <ms> quit
+//Times are from the start of the session. Blank lines and lines starting with # are skipped.
+//Replayed events go through SDL's event queue, so checkEvents() handles them exactly as live ones.
+class InputScript
+{
+public:
+	InputScript();
+	InputScript(const InputScript&) = delete;
+	InputScript& operator=(const InputScript&) = delete;
+	~InputScript();
+
+	//Reads a script to replay. Returns false if it can't be read or a line can't be parsed.
+	bool load(const std::string& path);
+	//Pushes every event due by elapsed ms onto SDL's queue.
+	void inject(Uint32 elapsed);
+	bool isFinished();
+
+	//Writes each event passed to record() to path, in the format load() reads.
+	bool startRecording(const std::string& path);
+	//Records e if it is input the carousel handles.
+	void record(const SDL_Event& e, Uint32 elapsed);
+
+private:
+	struct ScriptEvent {
+		Uint32 at;
+		SDL_Event event;
+	};
+
+	std::vector<ScriptEvent> events;
+	size_t next;
+	FILE* recording;
+};
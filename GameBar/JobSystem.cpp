@@ -0,0 +1,161 @@
+#include "JobSystem.h"
+#include "Trace.h"
+
+//which worker of which pool the current thread is, so jobs spawned from jobs stay on their worker's deque
+static thread_local JobSystem* currentSystem = nullptr;
+static thread_local int currentWorker = -1;
+
+bool Job::isDone() {
+	std::lock_guard<std::mutex> guard(lock);
+	return done;
+}
+
+int JobSystem::defaultWorkerCount() {
+	int cores = (int)std::thread::hardware_concurrency();
+	return cores - 1 > 2 ? cores - 1 : 2;
+}
+
+JobSystem::JobSystem(int workerCount) {
+	if (workerCount <= 0) {
+		workerCount = defaultWorkerCount();
+	}
+	wake = SDL_CreateSemaphore(0);
+	stopping = false;
+	draining = false;
+	for (int i = 0; i < workerCount; i++) {
+		workers.emplace_back(new Worker());
+	}
+	//start threads only once every worker exists, they steal from each other
+	for (int i = 0; i < workerCount; i++) {
+		workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	stopping = true;
+	for (size_t i = 0; i < workers.size(); i++) {
+		SDL_SemPost(wake);
+	}
+	for (auto& worker : workers) {
+		worker->thread.join();
+	}
+	SDL_DestroySemaphore(wake);
+}
+
+JobRef JobSystem::run(JobPriority priority, std::function<void()> fn, std::initializer_list<JobRef> after) {
+	return submit(priority, std::move(fn), after.begin(), after.size());
+}
+
+JobRef JobSystem::run(JobPriority priority, std::function<void()> fn, const std::vector<JobRef>& after) {
+	return submit(priority, std::move(fn), after.data(), after.size());
+}
+
+JobRef JobSystem::submit(JobPriority priority, std::function<void()> fn, const JobRef* after, size_t afterCount) {
+	JobRef job = std::make_shared<Job>();
+	job->fn = std::move(fn);
+	job->priority = priority;
+	job->pending = 1;
+	for (size_t i = 0; i < afterCount; i++) {
+		const JobRef& dependency = after[i];
+		if (!dependency) continue;
+		std::lock_guard<std::mutex> guard(dependency->lock);
+		if (!dependency->done) {
+			dependency->dependents.push_back(job);
+			job->pending++;
+		}
+	}
+	//drop the wiring count; if every dependency had already finished the job is ready now
+	if (--job->pending == 0) {
+		schedule(job);
+	}
+	return job;
+}
+
+int JobSystem::getWorkerCount() {
+	return (int)workers.size();
+}
+
+void JobSystem::schedule(const JobRef& job) {
+	if (currentSystem == this) {
+		Worker& worker = *workers[currentWorker];
+		std::lock_guard<std::mutex> guard(worker.lock);
+		worker.queues[job->priority].push_back(job);
+	}
+	else {
+		injected[job->priority].push(job);
+	}
+	SDL_SemPost(wake);
+}
+
+void JobSystem::execute(const JobRef& job) {
+	job->fn();
+	//release captures now rather than whenever the last JobRef goes away
+	job->fn = nullptr;
+	std::vector<JobRef> ready;
+	{
+		std::lock_guard<std::mutex> guard(job->lock);
+		job->done = true;
+		ready.swap(job->dependents);
+	}
+	for (const JobRef& dependent : ready) {
+		if (--dependent->pending == 0) {
+			schedule(dependent);
+		}
+	}
+}
+
+bool JobSystem::findJob(int index, JobRef* job) {
+	for (int p = 0; p < JOB_PRIORITY_COUNT; p++) {
+		//own work first, newest first while it's still warm in cache
+		{
+			Worker& self = *workers[index];
+			std::lock_guard<std::mutex> guard(self.lock);
+			if (!self.queues[p].empty()) {
+				*job = self.queues[p].back();
+				self.queues[p].pop_back();
+				return true;
+			}
+		}
+		//then work submitted from outside the pool
+		bool expected = false;
+		if (draining.compare_exchange_strong(expected, true)) {
+			bool found = injected[p].pop(job);
+			draining = false;
+			if (found) return true;
+		}
+		//then steal the oldest job from another worker
+		for (size_t i = 1; i < workers.size(); i++) {
+			Worker& victim = *workers[(index + i) % workers.size()];
+			std::lock_guard<std::mutex> guard(victim.lock);
+			if (!victim.queues[p].empty()) {
+				*job = victim.queues[p].front();
+				victim.queues[p].pop_front();
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void JobSystem::workerLoop(int index) {
+	currentSystem = this;
+	currentWorker = index;
+	setTraceThreadName("job worker");
+	//whether this worker already took the post for the job it finds next
+	bool woken = false;
+	while (!stopping) {
+		JobRef job;
+		if (findJob(index, &job)) {
+			//every schedule() posts once; take that post here if no wait did, or it wakes an idle worker for nothing
+			if (!woken) {
+				SDL_SemTryWait(wake);
+			}
+			woken = false;
+			execute(job);
+		}
+		else {
+			//so a job queued after the search above still wakes someone
+			woken = SDL_SemWaitTimeout(wake, 100) == 0;
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "LockFreeQueue.h"
+
+enum JobPriority {
+	JOB_PRIORITY_HIGH = 0,
+	JOB_PRIORITY_NORMAL,
+	JOB_PRIORITY_LOW,
+	JOB_PRIORITY_COUNT
+};
+
+class JobSystem;
+
+//One unit of work. Shared between the submitter, the jobs that wait on it and the worker that runs it.
+class Job
+{
+public:
+	bool isDone();
+
+private:
+	friend class JobSystem;
+	std::function<void()> fn;
+	JobPriority priority;
+	//unfinished dependencies, plus one until run() has finished wiring them up
+	std::atomic<int> pending;
+	std::mutex lock;
+	bool done = false;
+	std::vector<std::shared_ptr<Job>> dependents;
+};
+
+typedef std::shared_ptr<Job> JobRef;
+
+//Small work-stealing thread pool. Each worker has its own deques (one per priority); it pops its newest
+//work first and steals the oldest work from other workers when it runs dry. Jobs submitted from outside
+//the pool go through lock-free injection queues, so any thread can call run() without blocking, as long
+//as it doesn't pass dependencies (chaining onto another job takes that job's lock).
+class JobSystem
+{
+public:
+	//workers <= 0 picks a count from the number of cores
+	JobSystem(int workers = 0);
+
+	//Finishes running jobs and stops the workers. Queued jobs that haven't started are dropped.
+	~JobSystem();
+
+	//Queues fn to run once every job in after has finished.
+	JobRef run(JobPriority priority, std::function<void()> fn, std::initializer_list<JobRef> after = {});
+	//Same, for dependencies only known at run time.
+	JobRef run(JobPriority priority, std::function<void()> fn, const std::vector<JobRef>& after);
+
+	int getWorkerCount();
+
+	//Default worker count for this machine: one per core, leaving one for the UI thread, but at least two
+	//so a blocking download doesn't hold up decodes.
+	static int defaultWorkerCount();
+
+private:
+	struct Worker {
+		std::mutex lock;
+		std::deque<JobRef> queues[JOB_PRIORITY_COUNT];
+		std::thread thread;
+	};
+
+	void workerLoop(int index);
+	JobRef submit(JobPriority priority, std::function<void()> fn, const JobRef* after, size_t afterCount);
+	void schedule(const JobRef& job);
+	void execute(const JobRef& job);
+	bool findJob(int index, JobRef* job);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	MpscQueue<JobRef> injected[JOB_PRIORITY_COUNT];
+	//injection queues are single consumer, only one worker drains them at a time
+	std::atomic<bool> draining;
+	SDL_sem* wake;
+	std::atomic<bool> stopping;
+};
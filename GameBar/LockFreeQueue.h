@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//Bounded single producer, single consumer ring buffer. push() is only called from one thread and pop()
+//from one (possibly different) thread; neither ever blocks or takes a lock.
+template <typename T>
+class SpscQueue
+{
+public:
+	//capacity is rounded up to a power of two
+	SpscQueue(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) size *= 2;
+		slots.resize(size);
+		mask = size - 1;
+		head.store(0);
+		tail.store(0);
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	//Producer side. Returns false if the queue is full.
+	bool push(T item) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == slots.size()) {
+			return false;
+		}
+		slots[t & mask] = std::move(item);
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	//Consumer side. Returns false if the queue is empty.
+	bool pop(T* item) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		*item = std::move(slots[h & mask]);
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool empty() {
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+	std::vector<T> slots;
+	size_t mask;
+	//kept on separate cache lines so producer and consumer don't false share
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+};
+
+//Unbounded multiple producer, single consumer queue (Vyukov's intrusive list design). push() may be called
+//from any number of threads and never blocks; pop() must only be called from one thread.
+template <typename T>
+class MpscQueue
+{
+public:
+	MpscQueue() {
+		Node* stub = new Node();
+		head.store(stub);
+		tail = stub;
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	~MpscQueue() {
+		T ignored;
+		while (pop(&ignored)) {
+		}
+		delete tail;
+	}
+
+	void push(T item) {
+		Node* node = new Node();
+		node->item = std::move(item);
+		Node* prev = head.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	//Returns false if the queue is empty, or a push is halfway through (it will be visible shortly).
+	bool pop(T* item) {
+		Node* next = tail->next.load(std::memory_order_acquire);
+		if (next == nullptr) {
+			return false;
+		}
+		*item = std::move(next->item);
+		delete tail;
+		tail = next;
+		return true;
+	}
+
+private:
+	struct Node {
+		std::atomic<Node*> next{ nullptr };
+		T item{};
+	};
+
+	alignas(64) std::atomic<Node*> head;
+	alignas(64) Node* tail;
+};
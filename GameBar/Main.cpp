@@ -2,83 +2,295 @@
 #include <sstream>
 #include <cstdlib>
 #include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <ctime>
+#include <filesystem>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
-#include <direct.h>
 #include <curlpp/cURLpp.hpp>
-#include <curlpp/Easy.hpp>
-#include <curlpp/Options.hpp>
-#include <json/json.h>
-#include "Game.h"
+#include "GameStore.h"
 #include "Constants.h"
 #include "RenderEngine.h"
+#include "ImageRegistry.h"
+#include "AssetLoader.h"
+#include "JobSystem.h"
+#include "PrefetchPolicy.h"
+#include "CacheWindow.h"
+#include "ScheduleLoader.h"
+#include "DateIndex.h"
+#include "Download.h"
+#include "Snapshot.h"
+#include "UpdateSource.h"
+#include "PollingUpdateSource.h"
+#include "StreamUpdateSource.h"
+#include "FrameLog.h"
+#include "InputScript.h"
+#include "PhaseTimer.h"
+#include "Trace.h"
+#include "Metrics.h"
+#include "Watchdog.h"
 
-std::vector<Game> games;
+GameStore* games;
 
 RenderEngine* engine;
+JobSystem* jobs;
+AssetLoader* loader;
+ImageRegistry* images;
+PrefetchPolicy* prefetch;
+ScheduleLoader* schedules;
+DateIndex* dates;
+UpdateSource* updates;
+std::string streamUrl; //update stream followed, none if empty
+std::chrono::steady_clock::time_point startTime;
+FrameLog frameLog;
+int exitCode;
+
+//headless runs, see configure()
+bool headless;
+int frameLimit; //frames before quitting, 0 to run until asked
+Uint32 frameDelayMs;
+std::vector<int> captureFrames; //frame numbers to save, ascending
+size_t nextCapture;
+int capturingFrame; //frame whose capture is waiting for a complete frame, -1 if none
+std::string captureDir, goldenDir, frameTimesFile;
+double frameBudgetMs; //p95 frame time a run must stay within, 0 for no limit
+Uint32 stallDeadlineMs;
+
+//scripted sessions, see InputScript.h
+InputScript input;
+bool replaying;
+Uint32 scriptElapsed; //script time of the current frame when replaying
+Uint32 sessionStart; //ticks at the first frame, recorded input is timed from here
+std::string reportFile;
+std::string traceFile; //where F4 and exit write the trace
+struct TileVisit {
+	Uint32 since; //when the game came on screen
+	int frame; //last frame it was on screen
+	bool shown; //its image has been drawn
+};
+std::map<int, TileVisit> tileVisits; //games on screen, by gamePk
 
 int firstDisplayedIndex;
+IndexRange checkedCacheWindow; //cache window as of the last checkCache(), empty before the first
+Uint32 cacheTrimmedAt; //last ImageRegistry::trimCache()
 int selectedIndex;
-bool updateImgCache; //used to indicate a cache check after render
 bool quit;
 bool moveRequested;
+int seasonFirstDay, seasonLastDay;
+int fetchingBefore, fetchingAfter; //day being fetched to extend the loaded days at either end, -1 if none
+int anchorDay; //day the loaded days were started from, fetched again if it failed
+Uint32 dateRetryAt; //no day fetches before this after one failed
+std::deque<std::shared_ptr<ScheduleBatch>> refreshes; //live updates waiting to be applied, front one from refreshCursor on
+size_t refreshCursor;
+int gamesPatched;
+Uint64 patchReceivedAt; //arrival of the oldest update patched and not yet on screen, 0 if none
+int latencyCount;
+double latencyTotalMs, latencyMaxMs; //update arrival to the frame showing it
+//input being handled by checkEvents(), and the one that moved the carousel this frame, timed to the present
+//that shows it. Only one move is taken per frame, so there is at most one
+InputSource eventSource;
+Uint32 eventTimestamp;
+bool inputPending;
+InputSource pendingSource;
+Uint32 pendingTimestamp;
 
+void configure(int argc, char* argv[]);
 void setup();
 void cleanup();
 void run();
 void moveLeft();
 void moveRight();
 void checkCache();
+Uint32 prefetchClock();
+void warmCache(Uint32 now);
+void checkSchedule(Uint32 now);
+void addDay(int day, const ScheduleRecords& schedule, bool before);
+void addFetchedDay(const ScheduleBatch& batch, Uint32 now);
+void jumpToDay(int day);
+void jumpDays(int offset);
+void refreshLive(Uint32 now);
+void loadSnapshot(Snapshot& snapshot, int day);
+void checkHeadless(int frame);
+void trackTiles(int frame, Uint32 now);
+void writeReport(const std::string& path);
 
 int main(int argc, char* argv[]) {
+	//libcurl's global init isn't thread safe, so it happens here before any thread can fetch, and lasts until exit
+	curlpp::Cleanup curl;
+	configure(argc, argv);	//endpoints from the command line or environment
 	setup();	//makes cache directory, downloads+parses json, makes games, initializes display
 	run();		//renders display, monitors for inputs, updates games
 	cleanup();	
-	return 0;
+	return exitCode;	//non-zero when a headless run missed a golden frame or the frame budget
 }
 
-void setup() {
-	//make cache directory
-	if (_mkdir(cacheDir.c_str()) != 0) {
-		std::cout << "mkdir failed" << std::endl;
-		//return 1;
+//--origin URL (or GAMEBAR_ORIGIN) sends every fetch to a stand-in server such as ReplayServer.cpp, see setOrigin().
+//--stream URL (or GAMEBAR_STREAM) follows that update stream instead of updateStreamUrl, "" turns it off.
+//--headless renders offscreen on SDL's dummy video driver and quits after --frames N (HEADLESS_FRAMES).
+//--capture N,N,... saves the first complete frame from each of those on as --capture-dir DIR/frameN.png (frames),
+//  and --golden DIR compares each with DIR/frameN.png.
+//--frame-times FILE writes every frame's timing as CSV; --frame-budget MS fails the run past that p95 frame time.
+//--frame-delay MS waits that long between frames instead of FRAME_DELAY_MS.
+//--script FILE replays that input; its clock moves on by the frame delay each frame (1 ms when there is none),
+//  so every build sees each event on the same frame. --record-input FILE writes the session's input as a script.
+//--report FILE writes the session's frame, tile, cache and download figures as "metric,value" lines to compare runs by.
+//--trace FILE records a trace (Trace.h), written there by F4 and on exit; --trace-sample N follows one in N image
+//  requests instead of TRACE_SAMPLE_RATE. F4 starts tracing when it isn't on yet.
+//--metrics FILE (or GAMEBAR_METRICS) rewrites FILE with Prometheus metrics every METRICS_EXPORT_MS, and
+//  --metrics unix:PATH serves them on that UNIX socket instead, see Metrics.h.
+//--stall-ms MS reports frames taking longer than that instead of STALL_DEADLINE_MS (Watchdog.h), 0 for none.
+void configure(int argc, char* argv[]) {
+	streamUrl = updateStreamUrl;
+	frameDelayMs = FRAME_DELAY_MS;
+	stallDeadlineMs = STALL_DEADLINE_MS;
+	traceFile = "gamebar.trace.json";
+	int traceSample = TRACE_SAMPLE_RATE;
+	bool trace = false;
+	std::string metrics;
+	setTraceThreadName("main");
+	captureDir = "frames";
+	capturingFrame = -1;
+	if (const char* origin = getenv("GAMEBAR_ORIGIN")) {
+		setOrigin(origin);
 	}
+	if (const char* stream = getenv("GAMEBAR_STREAM")) {
+		streamUrl = stream;
+	}
+	if (const char* target = getenv("GAMEBAR_METRICS")) {
+		metrics = target;
+	}
+	for (int i = 1; i < argc; i++) {
+		std::string option = argv[i];
+		if (option == "--headless") {
+			headless = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cout << option << " needs a value" << std::endl;
+			break;
+		}
+		std::string value = argv[++i];
+		if (option == "--origin") {
+			setOrigin(value);
+		}
+		else if (option == "--stream") {
+			streamUrl = value;
+		}
+		else if (option == "--frames") {
+			frameLimit = atoi(value.c_str());
+		}
+		else if (option == "--frame-delay") {
+			frameDelayMs = (Uint32)atoi(value.c_str());
+		}
+		else if (option == "--capture") {
+			std::istringstream frames(value);
+			std::string frame;
+			while (std::getline(frames, frame, ',')) {
+				captureFrames.push_back(atoi(frame.c_str()));
+			}
+			std::sort(captureFrames.begin(), captureFrames.end());
+		}
+		else if (option == "--capture-dir") {
+			captureDir = value;
+		}
+		else if (option == "--golden") {
+			goldenDir = value;
+		}
+		else if (option == "--frame-times") {
+			frameTimesFile = value;
+		}
+		else if (option == "--frame-budget") {
+			frameBudgetMs = atof(value.c_str());
+		}
+		else if (option == "--script") {
+			replaying = input.load(value);
+			if (!replaying) {
+				exitCode = 1;
+			}
+		}
+		else if (option == "--record-input") {
+			input.startRecording(value);
+		}
+		else if (option == "--report") {
+			reportFile = value;
+		}
+		else if (option == "--trace") {
+			traceFile = value;
+			trace = true;
+		}
+		else if (option == "--trace-sample") {
+			traceSample = atoi(value.c_str());
+		}
+		else if (option == "--metrics") {
+			metrics = value;
+		}
+		else if (option == "--stall-ms") {
+			stallDeadlineMs = (Uint32)atoi(value.c_str());
+		}
+		else {
+			std::cout << "Unknown option " << option << std::endl;
+		}
+	}
+	if (trace) {
+		startTracing(traceSample);
+	}
+	if (!metrics.empty() && !startMetrics(metrics)) {
+		std::cout << "Metrics not exported" << std::endl;
+	}
+	if (headless && frameLimit == 0) {
+		frameLimit = HEADLESS_FRAMES;
+	}
+	std::error_code error;
+	//paths use '/' and std::filesystem, nothing Windows only
+	if (!captureFrames.empty() && !std::filesystem::create_directories(captureDir, error) && error) {
+		std::cout << "mkdir " << captureDir << " failed" << std::endl;
+	}
+	if (resolveUrl(scheduleUrl) != scheduleUrl) {
+		std::cout << "Fetching through " << resolveUrl(scheduleUrl) << std::endl;
+	}
+}
 
-	//download background image and json file
-	std::stringstream jsonString;
-
-	try {
-		curlpp::Cleanup cleaner;
-		curlpp::Easy request;
-
-		//json file
-		request.setOpt(new curlpp::options::Url(jsonUrl));
-
-		jsonString << request;
+void setup() {
+	startTime = std::chrono::steady_clock::now();
 
-		//background image
-		FILE* file = fopen(bgFile.c_str(), "wb");
-		if (!file) {
-			std::cout << "Error opening background file for writing" << std::endl;
-			return;
-		}
-		using namespace std::placeholders;
-		curlpp::options::WriteFunction* writer = new curlpp::options::WriteFunction(std::bind(&FileCallback, file, _1, _2, _3));
-		request.setOpt(writer);
-		request.setOpt(new curlpp::options::Url(backgroundUrl));
-		request.perform();
-		fclose(file);
+	//make cache directory, kept between runs along with the images, background and snapshot in it
+	std::error_code error;
+	if (!std::filesystem::create_directories(cacheDir, error) && error) {
+		std::cout << "mkdir " << cacheDir << " failed" << std::endl;
 	}
-	catch (curlpp::LogicError& e) {
-		std::cout << e.what() << std::endl;
-		//TODO: What now?
+	//setup is watched as the first frame, it fetches before anything is on screen
+	startWatchdog(stallDeadlineMs, stallLogFile);
+	beginWatchedFrame();
+
+	//a snapshot from the last run that holds the opening day fills the carousel before any fetch returns, and
+	//its days are only fetched to reconcile it. Otherwise the opening day's feeds are fetched and parsed on the
+	//job system while the background image downloads. They're just the schedule; editorial content and the
+	//neighbouring days come later in the background
+	jobs = new JobSystem();
+	schedules = new ScheduleLoader(jobs);
+	anchorDay = parseDay(startDate);
+	fetchingBefore = fetchingAfter = -1;
+	Snapshot snapshot;
+	bool haveSnapshot = snapshot.open(snapshotFile);
+	bool fromSnapshot = haveSnapshot && snapshot.contains(anchorDay);
+	if (!fromSnapshot) {
+		fetchingAfter = anchorDay;
+		schedules->requestDay(anchorDay);
 	}
-	catch (curlpp::RuntimeError& e) {
-		std::cout << e.what() << std::endl;
-		//TODO: What now?
+
+	//background image, already there unless this is the first run
+	if (!downloadFile(bgFile, backgroundUrl)) {
+		std::cout << "Background image unavailable" << std::endl;
 	}
 
-	//setup SDL
+	//setup SDL. Headless has no display, and the software renderer draws the same pixels on every build host
+	if (headless) {
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+		SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+	}
 	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
 		std::cout << "SDL_Init Error: " << SDL_GetError() << std::endl;
 		return;
@@ -88,52 +300,135 @@ void setup() {
 		return;
 	}
 
-	engine = new RenderEngine();
+	engine = new RenderEngine(jobs, headless);
+	loader = new AssetLoader(engine->getTexturePool(), jobs);
+	//push when there is a stream to follow, polling whenever it is down
+	updates = new PollingUpdateSource(jobs, refreshUrl, LIVE_REFRESH_MS);
+	if (!streamUrl.empty()) {
+		updates = new FallbackUpdateSource(new StreamUpdateSource(streamUrl), updates);
+	}
+	images = new ImageRegistry(engine->getTexturePool(), loader);
+	images->trimCache(IMAGE_CACHE_MAX_BYTES);
+	cacheTrimmedAt = SDL_GetTicks();
+	games = new GameStore(images);
+	games->setDisplayScale(engine->getDisplayScale());
+	prefetch = new PrefetchPolicy();
+	dates = new DateIndex();
+	seasonFirstDay = parseDay(seasonFirstDate);
+	seasonLastDay = parseDay(seasonLastDate);
+	dateRetryAt = 0;
+	refreshCursor = 0;
+	gamesPatched = 0;
+	patchReceivedAt = 0;
+	latencyCount = 0;
+	latencyTotalMs = latencyMaxMs = 0;
+	firstDisplayedIndex = 0;
+	selectedIndex = 0;
 	
-	//parse json
-	Json::Value root;
-	jsonString >> root;
-	int gameCount = root.get("totalGames", 0).asInt();
-	if (gameCount > 0) {
-		//sanitize json elements
-		if (!root["dates"].isArray() || !root["dates"][0]["games"].isArray() || root["dates"][0]["games"].size() != gameCount) {
-			std::cout << "Json parse error" << std::endl;
-			return;
+	//Construct list of games once the opening day is in; nothing else is being fetched yet. Reserve a few
+	//full days up front so the columns rarely have to grow.
+	games->reserve(MAX_LOADED_DAYS * 16 * FEED_COUNT);
+	if (fromSnapshot) {
+		loadSnapshot(snapshot, anchorDay);
+	}
+	else {
+		std::shared_ptr<ScheduleBatch> opening;
+		while (!schedules->poll(&opening)) {
+			SDL_Delay(1);
 		}
-		//Construct list of games
-		for (Json::Value i : root["dates"][0]["games"]) {
-			games.emplace_back(i, engine->getRenderer());
+		addFetchedDay(*opening, SDL_GetTicks());
+		//offline: the last run's days beat an empty carousel, paging and live updates pick up once the network is back
+		if (dates->empty() && haveSnapshot) {
+			loadSnapshot(snapshot, snapshot.getSelectedDay());
 		}
 	}
+	snapshot.close();
+	std::cout << "Schedule: " << games->size() << " games from " << FEED_COUNT << " feeds" << std::endl;
 
 	//cache first page of images, select first game, display first GAMES_ON_SCREEN games
-	firstDisplayedIndex = 0;
-	selectedIndex = 0;
-	for (int i = 0; i < GAMES_ON_SCREEN; i++) {
-		games[i].cache();
-		games[i].load();
-	}
+	prefetch->update(firstDisplayedIndex, games->size(), prefetchClock());
+	checkCache();
+	checkSchedule(SDL_GetTicks());
+	endWatchedFrame();
 }
 
 void cleanup() {
-	//destroy games
-	games.clear();
+	stopWatchdog();
+	//stop the loader feeding the workers, then the workers, whose jobs reference the loader, the engine's fonts and the texture pool
+	loader->stop();
+	delete jobs;
+	delete loader;
+	schedules->printStats();
+	updates->printStats();
+	std::cout << "Live updates: " << gamesPatched << " games patched";
+	if (latencyCount > 0) {
+		std::cout << ", arrival to frame " << latencyTotalMs / latencyCount << " ms average, " << latencyMaxMs << " ms max";
+	}
+	std::cout << std::endl;
+	frameLog.printStats();
+	printPhaseStats();
+	if (isTracing()) {
+		writeTrace(traceFile);
+	}
+	stopMetrics();
+	if (!frameTimesFile.empty()) {
+		frameLog.writeCsv(frameTimesFile);
+	}
+	if (!reportFile.empty()) {
+		writeReport(reportFile);
+	}
+	if (frameBudgetMs > 0 && frameLog.percentile(95) > frameBudgetMs * 1000) {
+		std::cout << "Frame budget exceeded: p95 " << frameLog.percentile(95) / 1000 << " ms, budget " << frameBudgetMs << " ms" << std::endl;
+		exitCode = 1;
+	}
+	//the polling source runs jobs, so it goes after them
+	delete updates;
+	refreshes.clear();
+	delete schedules;
 
-	free(engine);
+	//the loaded days for the next start
+	if (!dates->empty() && writeSnapshot(snapshotFile, games, dates, dates->dayOf(selectedIndex))) {
+		std::cout << "Snapshot: " << games->size() << " games saved" << std::endl;
+	}
+
+	//destroy games
+	delete games;
+	prefetch->printStats();
+	delete prefetch;
+	delete dates;
 
-	//delete background image(all other cached files deleted by games)
-	remove(bgFile.c_str());
+	//shared images go before the engine that owns their texture pool
+	std::cout << "Images: " << images->getDownloadCount() << " downloaded, " << images->getDecodeCount() << " decoded, "
+		<< images->getCancelCount() << " cancelled, " << images->getDiskHitCount() << " found on disk, "
+		<< images->getDiskMissCount() << " not; " << getDownloadedBytes() / 1024 << " KB downloaded in all" << std::endl;
+	delete images;
 
-	//delete cache directory
-	_rmdir(cacheDir.c_str());
+	//delete, not free(), so the destructor releases SDL resources and the texture pool
+	delete engine;
 
 	TTF_Quit();
 	SDL_Quit();
 }
 
+//Notes that the event being handled moved the carousel.
+void inputTaken() {
+	inputPending = true;
+	pendingSource = eventSource;
+	pendingTimestamp = eventTimestamp;
+}
+
 void checkEvents() {
 	SDL_Event e;
 	while (SDL_PollEvent(&e)) {
+		input.record(e, SDL_GetTicks() - sessionStart);
+		eventTimestamp = e.common.timestamp;
+		if (e.type == SDL_KEYDOWN) {
+			bool keypad = e.key.keysym.scancode == SDL_SCANCODE_KP_4 || e.key.keysym.scancode == SDL_SCANCODE_KP_6;
+			eventSource = keypad ? INPUT_KEYPAD : INPUT_KEYBOARD;
+		}
+		else {
+			eventSource = e.type == SDL_CONTROLLERAXISMOTION ? INPUT_AXIS : INPUT_DPAD;
+		}
 		switch (e.type) {
 		case SDL_QUIT:
 			quit = true;
@@ -148,9 +443,37 @@ void checkEvents() {
 			case SDL_SCANCODE_KP_6:
 				moveRight();
 				break;
+			case SDL_SCANCODE_UP:
+				jumpDays(1);
+				break;
+			case SDL_SCANCODE_DOWN:
+				jumpDays(-1);
+				break;
+			case SDL_SCANCODE_PAGEUP:
+				jumpDays(7);
+				break;
+			case SDL_SCANCODE_PAGEDOWN:
+				jumpDays(-7);
+				break;
 			case SDL_SCANCODE_ESCAPE:
 				quit = true;
 				break;
+			case SDL_SCANCODE_F3:
+				//held down it would flicker
+				if (!e.key.repeat) {
+					engine->toggleHud();
+				}
+				break;
+			case SDL_SCANCODE_F4:
+				if (e.key.repeat) break;
+				if (isTracing()) {
+					writeTrace(traceFile);
+				}
+				else {
+					startTracing(TRACE_SAMPLE_RATE);
+					std::cout << "Tracing, F4 again writes " << traceFile << std::endl;
+				}
+				break;
 			default:
 				break;
 			}
@@ -194,10 +517,12 @@ void moveLeft() {
 	if (selectedIndex > 0) {
 		selectedIndex--;
 		moveRequested = true;
+		inputTaken();
+		prefetch->onMove(-1, prefetchClock());
 		//if we're off the left of the screen, move the screen
 		if (selectedIndex < firstDisplayedIndex) {
 			firstDisplayedIndex--;
-			updateImgCache = true;
+			prefetch->recordArrival((*games)[firstDisplayedIndex].isLoaded());
 		}
 	}
 };
@@ -206,13 +531,15 @@ void moveRight() {
 	//only one move allowed per cycle
 	if (moveRequested) return;
 	//can't move right past end of list
-	if (selectedIndex < games.size() - 1) {
+	if (selectedIndex < games->size() - 1) {
 		selectedIndex++;
 		moveRequested = true;
+		inputTaken();
+		prefetch->onMove(1, prefetchClock());
 		//if we're off the right of the screen, move the screen
 		if (selectedIndex >= firstDisplayedIndex + GAMES_ON_SCREEN) {
 			firstDisplayedIndex++;
-			updateImgCache = true;
+			prefetch->recordArrival((*games)[firstDisplayedIndex + GAMES_ON_SCREEN - 1].isLoaded());
 		}
 	}
 };
@@ -222,34 +549,515 @@ void run() {
 	//render as requested
 	//clear action queue after render
 	quit = false;
+	bool firstFrame = true;
+	int frame = 0;
+	double ticksPerUs = SDL_GetPerformanceFrequency() / 1e6;
+	sessionStart = SDL_GetTicks();
 	while (!quit) {
+		Uint64 frameStart = SDL_GetPerformanceCounter();
+		beginWatchedFrame();
 		moveRequested = false;
-		checkEvents();
+		if (replaying) {
+			scriptElapsed = frame * std::max<Uint32>(frameDelayMs, 1);
+			input.inject(scriptElapsed);
+		}
+		{
+			PhaseTimer timer(PHASE_EVENTS);
+			checkEvents();
+		}
+		//pick up whatever the loader thread finished since last frame
+		{
+			PhaseTimer timer(PHASE_UPLOAD);
+			images->update();
+		}
 		//render screen again
-		engine->renderScene(firstDisplayedIndex, selectedIndex, &games);
-		//TODO: This should be a separate thread maybe
-		if (updateImgCache) {
-			checkCache();
+		Uint64 renderStart = SDL_GetPerformanceCounter();
+		Phase outer = enterWatchedPhase(PHASE_RENDER);
+		engine->renderScene(firstDisplayedIndex, selectedIndex, games);
+		leaveWatchedPhase(outer);
+		Uint64 renderEnd = SDL_GetPerformanceCounter();
+		if (inputPending) {
+			//presented by now; a jump to a day not loaded yet shows the empty carousel it starts from
+			recordInputLatency(pendingSource, SDL_GetTicks() - pendingTimestamp);
+			inputPending = false;
+		}
+		recordPhase(PHASE_RENDER, renderEnd - renderStart);
+		traceSpan("phase", "render", renderStart, renderEnd);
+		trackTiles(frame, SDL_GetTicks());
+		if (firstFrame) {
+			std::cout << "First frame after " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() << " ms" << std::endl;
+			firstFrame = false;
+		}
+		//once the patched text is on screen, not just queued to be rasterized again
+		if (patchReceivedAt != 0 && !engine->isTextPending()) {
+			double ms = (SDL_GetPerformanceCounter() - patchReceivedAt) * 1000.0 / SDL_GetPerformanceFrequency();
+			latencyCount++;
+			latencyTotalMs += ms;
+			latencyMaxMs = std::max(latencyMaxMs, ms);
+			patchReceivedAt = 0;
+		}
+		//only queues work for the loader thread, nothing here blocks.
+		//the windows also change without a move, as the scroll speed decays
+		Uint32 now = SDL_GetTicks();
+		{
+			PhaseTimer timer(PHASE_CACHE);
+			Uint32 prefetchNow = prefetchClock();
+			if (prefetch->update(firstDisplayedIndex, games->size(), prefetchNow)) {
+				checkCache();
+			}
+			warmCache(prefetchNow);
+			//downloads keep adding files, the cache is held to its size while running too
+			if (now - cacheTrimmedAt >= IMAGE_CACHE_TRIM_MS) {
+				images->trimCache(IMAGE_CACHE_MAX_BYTES);
+				cacheTrimmedAt = now;
+			}
 		}
-		updateImgCache = false;
-		SDL_Delay(250);
+		{
+			PhaseTimer timer(PHASE_SCHEDULE);
+			checkSchedule(now);
+		}
+		{
+			PhaseTimer timer(PHASE_LIVE);
+			refreshLive(now);
+		}
+		Uint64 frameEnd = SDL_GetPerformanceCounter();
+		recordPhase(PHASE_FRAME, frameEnd - frameStart);
+		traceSpan("phase", "frame", frameStart, frameEnd);
+		rollPhases(now);
+		framesRendered.add();
+		gamesLoaded.set(games->size());
+		exportMetrics(now);
+		endWatchedFrame();
+		frameLog.add((frameEnd - frameStart) / ticksPerUs, (renderEnd - renderStart) / ticksPerUs);
+		frame++;
+		checkHeadless(frame);
+		SDL_Delay(frameDelayMs);
 	};
 };
 
+//Times each game from coming on screen to its image being drawn. A game that leaves before then isn't counted.
+void trackTiles(int frame, Uint32 now) {
+	for (int i = firstDisplayedIndex; i < firstDisplayedIndex + GAMES_ON_SCREEN && i < games->size(); i++) {
+		Game game = (*games)[i];
+		auto visit = tileVisits.find(game.getId());
+		if (visit == tileVisits.end()) {
+			visit = tileVisits.insert({ game.getId(), TileVisit{ now, frame, false } }).first;
+		}
+		visit->second.frame = frame;
+		if (!visit->second.shown && game.isLoaded()) {
+			frameLog.addTileVisible(now - visit->second.since);
+			visit->second.shown = true;
+		}
+	}
+	for (auto visit = tileVisits.begin(); visit != tileVisits.end();) {
+		visit = visit->second.frame == frame ? std::next(visit) : tileVisits.erase(visit);
+	}
+}
+
+void writeReport(const std::string& path) {
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file) {
+		std::cout << "Error opening file " << path << "!" << std::endl;
+		return;
+	}
+	fprintf(file, "metric,value\n");
+	fprintf(file, "frames,%d\n", frameLog.getCount());
+	for (int p : { 50, 95, 99, 100 }) {
+		fprintf(file, "frame_p%d_us,%.0f\n", p, frameLog.percentile(p));
+	}
+	for (int p : { 50, 95, 100 }) {
+		fprintf(file, "render_p%d_us,%.0f\n", p, frameLog.renderPercentile(p));
+	}
+	for (int source = 0; source < INPUT_SOURCE_COUNT; source++) {
+		PhaseSummary summary = summarizeInputRun((InputSource)source);
+		const char* name = inputSourceName((InputSource)source);
+		fprintf(file, "input_%s_count,%u\n", name, summary.count);
+		fprintf(file, "input_%s_p50_ms,%.0f\ninput_%s_p95_ms,%.0f\n", name, summary.p50Us / 1000, name, summary.p95Us / 1000);
+	}
+	fprintf(file, "tiles_shown,%d\n", frameLog.getTileCount());
+	for (int p : { 50, 95, 100 }) {
+		fprintf(file, "tile_visible_p%d_ms,%.0f\n", p, frameLog.tilePercentile(p));
+	}
+	fprintf(file, "prefetch_arrivals,%d\nprefetch_hits,%d\n", prefetch->getArrivals(), prefetch->getHits());
+	fprintf(file, "disk_hits,%d\ndisk_misses,%d\n", images->getDiskHitCount(), images->getDiskMissCount());
+	fprintf(file, "image_downloads,%d\ndecodes,%d\ncancels,%d\n", images->getDownloadCount(), images->getDecodeCount(), images->getCancelCount());
+	fprintf(file, "bytes_downloaded,%llu\n", (unsigned long long)getDownloadedBytes());
+	fclose(file);
+}
+
+//Starts and checks captures as their frames come up, and ends the run at the frame limit.
+void checkHeadless(int frame) {
+	if (capturingFrame >= 0 && !engine->isCapturePending()) {
+		std::string name = "frame" + std::to_string(capturingFrame) + ".png";
+		if (!goldenDir.empty()) {
+			double differing = compareImages(captureDir + "/" + name, goldenDir + "/" + name, GOLDEN_TOLERANCE);
+			if (differing < 0 || differing > GOLDEN_MAX_DIFFERING) {
+				std::cout << "Frame " << capturingFrame << " doesn't match " << goldenDir << "/" << name;
+				if (differing >= 0) {
+					std::cout << ", " << differing * 100 << "% of pixels differ";
+				}
+				std::cout << std::endl;
+				exitCode = 1;
+			}
+		}
+		capturingFrame = -1;
+	}
+	//one capture at a time, a later one waits for the earlier frame to complete
+	if (capturingFrame < 0 && nextCapture < captureFrames.size() && frame >= captureFrames[nextCapture]) {
+		capturingFrame = captureFrames[nextCapture++];
+		engine->captureFrame(captureDir + "/frame" + std::to_string(capturingFrame) + ".png");
+	}
+	if (frameLimit > 0 && frame >= frameLimit) {
+		if (capturingFrame >= 0 || nextCapture < captureFrames.size()) {
+			std::cout << "Frame " << (capturingFrame >= 0 ? capturingFrame : captureFrames[nextCapture]) << " never completed, images or text still loading" << std::endl;
+			exitCode = 1;
+		}
+		quit = true;
+	}
+}
+
 void checkCache() {
-	for (int i = 0; i < games.size(); i++) {
-		//make sure all games on screen and +/- 2 are cached, +/- 1 are loaded
-		if (i < firstDisplayedIndex - 2 || i > firstDisplayedIndex + GAMES_ON_SCREEN + 1) {
-			games[i].free();
-			games[i].uncache();
+	checkCacheWindow(games, prefetch, &checkedCacheWindow, firstDisplayedIndex);
+}
+
+//Time for PrefetchPolicy. A script's own clock when replaying, so scroll speed, window sizes and warming follow
+//the script's pace, not how fast this build gets through its frames. Counted from 1, PrefetchPolicy takes 0 for
+//no move yet.
+Uint32 prefetchClock() {
+	return replaying ? scriptElapsed + 1 : SDL_GetTicks();
+}
+
+//now on prefetchClock()
+void warmCache(Uint32 now) {
+	//warming waits for the screen, so it never competes with what the user is looking at
+	bool screenLoaded = true;
+	for (int i = firstDisplayedIndex; i < firstDisplayedIndex + GAMES_ON_SCREEN && i < games->size(); i++) {
+		if ((*games)[i].isLoading()) {
+			screenLoaded = false;
+		}
+	}
+	int index;
+	while ((index = prefetch->nextWarm(screenLoaded, now)) >= 0) {
+		Game game = (*games)[index];
+		if (game.isCached() || game.isCaching()) continue;
+		game.cache(JOB_PRIORITY_LOW);
+		prefetch->warmStarted(now);
+		break;
+	}
+}
+
+//Moves games' positions after count were inserted (count > 0) or removed (count < 0) before the screen.
+void shiftIndices(int count) {
+	firstDisplayedIndex += count;
+	selectedIndex += count;
+	checkedCacheWindow = checkedCacheWindow.shifted(count);
+	prefetch->shift(count);
+}
+
+//Drops days from whichever end is farther from the selection once more than MAX_LOADED_DAYS are held,
+//so memory stays bounded however far the user browses.
+void trimDays() {
+	while (dates->getDayCount() > MAX_LOADED_DAYS) {
+		int firstCount = dates->gameCountOf(dates->getFirstDay());
+		int lastCount = dates->gameCountOf(dates->getLastDay());
+		//only drop a day if the selection stays far enough from the new edge that paging won't fetch it straight back
+		bool canDropFirst = selectedIndex - firstCount >= DATE_PAGE_MARGIN;
+		bool canDropLast = games->size() - lastCount - 1 - selectedIndex >= DATE_PAGE_MARGIN;
+		int selectedDay = dates->dayOf(selectedIndex);
+		if (canDropFirst && (!canDropLast || selectedDay - dates->getFirstDay() > dates->getLastDay() - selectedDay)) {
+			games->eraseGames(0, firstCount);
+			dates->popFront();
+			shiftIndices(-firstCount);
+		}
+		else if (canDropLast) {
+			games->eraseGames(games->size() - lastCount, lastCount);
+			dates->popBack();
+		}
+		else {
+			break;
+		}
+	}
+}
+
+void addDay(int day, const ScheduleRecords& schedule, bool before) {
+	const GameRecord* dayGames = nullptr;
+	int count = 0;
+	for (const DateRecord& date : schedule.dates) {
+		//sanitize json elements
+		if (parseDay(date.date) == day && date.firstGame + date.gameCount <= (int)schedule.games.size()) {
+			dayGames = schedule.games.data() + date.firstGame;
+			count = date.gameCount;
+		}
+	}
+	//existing games only move, their images and text stay loaded
+	if (before) {
+		games->insertGames(0, dayGames, count, schedule.cuts);
+		dates->prepend(day, count);
+		shiftIndices(count);
+	}
+	else {
+		games->insertGames(games->size(), dayGames, count, schedule.cuts);
+		dates->append(day, count);
+	}
+	trimDays();
+}
+
+void jumpToDay(int day) {
+	day = std::max(seasonFirstDay, std::min(seasonLastDay, day));
+	if (dates->contains(day)) {
+		//an empty day lands on the next day's first game
+		selectedIndex = std::min(dates->firstIndexOf(day), games->size() - 1);
+		firstDisplayedIndex = std::max(0, std::min(selectedIndex, games->size() - GAMES_ON_SCREEN));
+		return;
+	}
+	//not loaded: start over on that day, the pager fills in around it
+	games->clear();
+	dates->clear();
+	checkedCacheWindow = IndexRange();
+	firstDisplayedIndex = selectedIndex = 0;
+	anchorDay = day;
+	fetchingBefore = -1;
+	fetchingAfter = day;
+	schedules->requestDay(day);
+}
+
+void jumpDays(int offset) {
+	//only one move allowed per cycle
+	if (moveRequested) return;
+	moveRequested = true;
+	int day = dates->dayOf(selectedIndex);
+	if (day < 0) return;
+	inputTaken();
+	day += offset;
+	//skip days without games in the direction of travel
+	while (dates->contains(day) && dates->gameCountOf(day) == 0) {
+		day += offset > 0 ? 1 : -1;
+	}
+	jumpToDay(day);
+}
+
+//Merges editorial content that came back. Games keep their index and handles, only changed text is rasterized again.
+void mergeEditorial(const ScheduleBatch& batch) {
+	if (batch.ok) {
+		for (const GameRecord& record : batch.records.games) {
+			int index = games->mergeEditorial(record, batch.records.cuts);
+			if (index >= 0) {
+				engine->invalidateText(record.gamePk);
+			}
+		}
+	}
+	//games the response left out have nothing to hydrate; games dropped since aren't in the store any more
+	for (int gamePk : batch.gamePks) {
+		int index = games->indexOf(gamePk);
+		if (index >= 0 && games->getEditorialState(index) == EDITORIAL_REQUESTED) {
+			games->setEditorialState(index, batch.ok ? EDITORIAL_DONE : EDITORIAL_FAILED);
+		}
+	}
+}
+
+//Adds a fetched day at whichever end it belongs to, if it still does.
+void addFetchedDay(const ScheduleBatch& batch, Uint32 now) {
+	bool wanted = batch.day == fetchingBefore || batch.day == fetchingAfter;
+	if (batch.day == fetchingBefore) fetchingBefore = -1;
+	if (batch.day == fetchingAfter) fetchingAfter = -1;
+	//fetched before a jump elsewhere
+	if (!wanted) return;
+	if (!batch.ok) {
+		dateRetryAt = now + DATE_RETRY_MS;
+		httpRetries[RETRY_DAY].add();
+		return;
+	}
+	if (dates->empty()) {
+		addDay(batch.day, batch.records, false);
+	}
+	else if (batch.day == dates->getFirstDay() - 1) {
+		addDay(batch.day, batch.records, true);
+	}
+	else if (batch.day == dates->getLastDay() + 1) {
+		addDay(batch.day, batch.records, false);
+	}
+}
+
+//Fetches the days either side of the loaded ones as the selection nears an edge. Both can be in flight at once.
+void pageDates(Uint32 now) {
+	if ((int)(now - dateRetryAt) < 0) return;
+	if (dates->empty()) {
+		//the day everything starts from failed
+		if (fetchingAfter < 0) {
+			fetchingAfter = anchorDay;
+			schedules->requestDay(anchorDay);
 		}
-		else if (i < firstDisplayedIndex - 1 || i > firstDisplayedIndex + GAMES_ON_SCREEN) {
-			games[i].free();
-			games[i].cache();
+		return;
+	}
+	if (fetchingBefore < 0 && dates->getFirstDay() > seasonFirstDay && selectedIndex < DATE_PAGE_MARGIN) {
+		fetchingBefore = dates->getFirstDay() - 1;
+		schedules->requestDay(fetchingBefore);
+	}
+	if (fetchingAfter < 0 && dates->getLastDay() < seasonLastDay && games->size() - 1 - selectedIndex < DATE_PAGE_MARGIN) {
+		fetchingAfter = dates->getLastDay() + 1;
+		schedules->requestDay(fetchingAfter);
+	}
+}
+
+//Requests editorial content for the cache window and a batch either side of it, nearest the screen first.
+void requestEditorial() {
+	IndexRange window = prefetch->getCacheWindow();
+	int first = std::max(window.first - EDITORIAL_BATCH_SIZE, 0);
+	int last = std::min(window.last + EDITORIAL_BATCH_SIZE, games->size() - 1);
+	int room = (EDITORIAL_MAX_PENDING - schedules->getPendingEditorial()) * EDITORIAL_BATCH_SIZE;
+	std::vector<int> gamePks;
+	for (int distance = 0; (int)gamePks.size() < room; distance++) {
+		int right = firstDisplayedIndex + distance;
+		int left = firstDisplayedIndex - distance - 1;
+		if (right > last && left < first) break;
+		for (int index : { right, left }) {
+			if (index < first || index > last || (int)gamePks.size() >= room) continue;
+			if (games->getEditorialState(index) != EDITORIAL_NONE) continue;
+			games->setEditorialState(index, EDITORIAL_REQUESTED);
+			gamePks.push_back((*games)[index].getId());
+		}
+	}
+	for (size_t i = 0; i < gamePks.size(); i += EDITORIAL_BATCH_SIZE) {
+		size_t end = std::min(gamePks.size(), i + EDITORIAL_BATCH_SIZE);
+		schedules->requestEditorial(std::vector<int>(gamePks.begin() + i, gamePks.begin() + end));
+	}
+}
+
+void checkSchedule(Uint32 now) {
+	std::shared_ptr<ScheduleBatch> batch;
+	while (schedules->poll(&batch)) {
+		if (batch->refresh) {
+			//a snapshot day reconciled; one that failed keeps the snapshot's games
+			if (batch->ok) {
+				refreshes.push_back(batch);
+			}
+		}
+		else if (batch->day >= 0) {
+			addFetchedDay(*batch, now);
 		}
 		else {
-			games[i].cache();
-			games[i].load();
+			mergeEditorial(*batch);
+		}
+	}
+	pageDates(now);
+	requestEditorial();
+}
+
+//Has the next checkCache() look over first..last too, after games there moved, so none keeps images outside the windows.
+void recheckCache(int first, int last) {
+	if (checkedCacheWindow.last < checkedCacheWindow.first) return;
+	checkedCacheWindow.first = std::min(checkedCacheWindow.first, first);
+	checkedCacheWindow.last = std::max(checkedCacheWindow.last, last);
+	checkCache();
+}
+
+//Puts a patched game whose start time changed back in order within its day, moving only the games between.
+void reorderGame(int index) {
+	int day = dates->dayOf(index);
+	if (day < 0) return;
+	int first = dates->firstIndexOf(day);
+	int last = first + dates->gameCountOf(day);
+	int64_t start = games->getStartTime(index);
+	int to = index;
+	if (index > first && games->getStartTime(index - 1) > start) {
+		to = games->findPosition(first, index, start);
+	}
+	else if (index + 1 < last && games->getStartTime(index + 1) < start) {
+		to = games->findPosition(index + 1, last, start) - 1;
+	}
+	if (to == index) return;
+	games->moveGame(index, to);
+	//the selection stays on the game it was on
+	if (selectedIndex == index) {
+		selectedIndex = to;
+	}
+	else if (index < to && selectedIndex > index && selectedIndex <= to) {
+		selectedIndex--;
+	}
+	else if (to < index && selectedIndex >= to && selectedIndex < index) {
+		selectedIndex++;
+	}
+	firstDisplayedIndex = std::min(firstDisplayedIndex, selectedIndex);
+	firstDisplayedIndex = std::max(firstDisplayedIndex, selectedIndex - GAMES_ON_SCREEN + 1);
+	recheckCache(std::min(index, to), std::max(index, to));
+}
+
+//Adds a game a feed has gained since its day was loaded, in start order. Returns false if its day isn't loaded.
+bool insertLiveGame(const GameRecord& record, const std::vector<CutRecord>& cuts) {
+	int day = parseDay(record.officialDate);
+	if (!dates->contains(day)) return false;
+	int first = dates->firstIndexOf(day);
+	int position = games->findPosition(first, first + dates->gameCountOf(day), gameStartTime(record));
+	games->insertGames(position, &record, 1, cuts);
+	dates->addGames(day, 1);
+	if (position <= selectedIndex) {
+		shiftIndices(1);
+	}
+	recheckCache(position, checkedCacheWindow.last + 1);
+	return true;
+}
+
+//Applies live updates a few changed games per frame. Unchanged games are skipped on their fingerprint, changed
+//ones only have their text rendered again, and a game whose start moved is re-merged into its day in place.
+void applyRefreshes() {
+	int patched = 0;
+	while (!refreshes.empty() && patched < LIVE_PATCHES_PER_FRAME) {
+		const ScheduleBatch& batch = *refreshes.front();
+		if (refreshCursor >= batch.records.games.size()) {
+			refreshes.pop_front();
+			refreshCursor = 0;
+			continue;
 		}
+		const GameRecord& record = batch.records.games[refreshCursor];
+		bool textChanged;
+		int index = games->patchGame(record, batch.fingerprints[refreshCursor], batch.records.cuts, &textChanged);
+		bool applied = index >= 0;
+		if (applied) {
+			if (textChanged) {
+				engine->invalidateText(record.gamePk);
+			}
+			reorderGame(index);
+		}
+		else if (games->indexOf(record.gamePk) < 0) {
+			//new to a loaded day; games whose day was dropped or jumped away from are skipped
+			applied = insertLiveGame(record, batch.records.cuts);
+		}
+		if (applied) {
+			patched++;
+			if (batch.receivedAt != 0 && (patchReceivedAt == 0 || batch.receivedAt < patchReceivedAt)) {
+				patchReceivedAt = batch.receivedAt;
+			}
+		}
+		refreshCursor++;
+	}
+	gamesPatched += patched;
+}
+
+//Fills the carousel from the last run's snapshot, selecting day (or the first day if the snapshot lacks it),
+//then fetches each of its days again so new scores, headlines and games are patched in as live updates are.
+void loadSnapshot(Snapshot& snapshot, int day) {
+	snapshot.loadInto(games, dates);
+	if (dates->empty()) return;
+	if (!dates->contains(day)) {
+		day = dates->getFirstDay();
+	}
+	anchorDay = day;
+	jumpToDay(day);
+	for (int loaded = dates->getFirstDay(); loaded <= dates->getLastDay(); loaded++) {
+		schedules->requestDay(loaded, true);
+	}
+	std::cout << "Snapshot: " << games->size() << " games from " << (time(nullptr) - snapshot.getSavedAt()) / 60 << " minutes ago" << std::endl;
+}
+
+//Keeps the update source following the loaded days and queues what it delivers.
+void refreshLive(Uint32 now) {
+	applyRefreshes();
+	if (!dates->empty()) {
+		updates->watch(dates->getFirstDay(), dates->getLastDay());
+	}
+	updates->update(now);
+	std::shared_ptr<ScheduleBatch> batch;
+	while (updates->poll(&batch)) {
+		refreshes.push_back(batch);
 	}
 }
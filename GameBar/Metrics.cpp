@@ -0,0 +1,391 @@
+#include "Metrics.h"
+#include "Constants.h"
+#include "Trace.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET Socket;
+#else
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int Socket;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+#endif
+
+//upper bounds in seconds, from a tenth of a millisecond for the cheap phases up to slow downloads
+static const double METRIC_BUCKETS[MetricHistogram::BUCKET_COUNT] = {
+	0.0001, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.016, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};
+
+//in definition order; filled during static initialization, read only after
+static std::vector<Metric*>& registry() {
+	static std::vector<Metric*> metrics;
+	return metrics;
+}
+
+MetricCounter httpRequests[HTTP_KIND_COUNT] = {
+	{ "gamebar_http_requests_total", "Fetches started.", "kind=\"image\"" },
+	{ "gamebar_http_requests_total", "Fetches started.", "kind=\"schedule\"" },
+	{ "gamebar_http_requests_total", "Fetches started.", "kind=\"poll\"" },
+	{ "gamebar_http_requests_total", "Fetches started.", "kind=\"stream\"" }
+};
+MetricCounter httpFailures[HTTP_KIND_COUNT] = {
+	{ "gamebar_http_failures_total", "Fetches that failed.", "kind=\"image\"" },
+	{ "gamebar_http_failures_total", "Fetches that failed.", "kind=\"schedule\"" },
+	{ "gamebar_http_failures_total", "Fetches that failed.", "kind=\"poll\"" },
+	{ "gamebar_http_failures_total", "Fetches that failed.", "kind=\"stream\"" }
+};
+//image downloads nobody wanted any more, stream connections dropped to follow other days or to stop
+MetricCounter httpCancelled[HTTP_KIND_COUNT] = {
+	{ "gamebar_http_cancelled_total", "Fetches called off before they finished.", "kind=\"image\"" },
+	{ "gamebar_http_cancelled_total", "Fetches called off before they finished.", "kind=\"schedule\"" },
+	{ "gamebar_http_cancelled_total", "Fetches called off before they finished.", "kind=\"poll\"" },
+	{ "gamebar_http_cancelled_total", "Fetches called off before they finished.", "kind=\"stream\"" }
+};
+MetricCounter httpBytes[HTTP_KIND_COUNT] = {
+	{ "gamebar_http_received_bytes_total", "Response body bytes received.", "kind=\"image\"" },
+	{ "gamebar_http_received_bytes_total", "Response body bytes received.", "kind=\"schedule\"" },
+	{ "gamebar_http_received_bytes_total", "Response body bytes received.", "kind=\"poll\"" },
+	{ "gamebar_http_received_bytes_total", "Response body bytes received.", "kind=\"stream\"" }
+};
+//for a stream, how long the connection lasted
+MetricHistogram httpSeconds[HTTP_KIND_COUNT] = {
+	{ "gamebar_http_request_seconds", "Time from starting a fetch to its last byte.", "kind=\"image\"" },
+	{ "gamebar_http_request_seconds", "Time from starting a fetch to its last byte.", "kind=\"schedule\"" },
+	{ "gamebar_http_request_seconds", "Time from starting a fetch to its last byte.", "kind=\"poll\"" },
+	{ "gamebar_http_request_seconds", "Time from starting a fetch to its last byte.", "kind=\"stream\"" }
+};
+MetricCounter httpRetries[RETRY_KIND_COUNT] = {
+	{ "gamebar_http_retries_total", "Fetches scheduled again after a failure.", "kind=\"day\"" },
+	{ "gamebar_http_retries_total", "Fetches scheduled again after a failure.", "kind=\"stream\"" },
+	{ "gamebar_http_retries_total", "Fetches scheduled again after a failure.", "kind=\"image\"" }
+};
+MetricCounter diskCacheHits("gamebar_disk_cache_hits_total", "Images wanted that were already in the image cache.");
+MetricCounter diskCacheMisses("gamebar_disk_cache_misses_total", "Images wanted that had to be downloaded.");
+MetricGauge texturesResident("gamebar_textures_resident", "Pooled textures holding an image.");
+MetricGauge textureBytesResident("gamebar_texture_resident_bytes", "Pixel bytes of the pooled textures holding an image.");
+MetricGauge decodeBufferBytes("gamebar_decode_buffer_bytes", "Bytes held by decode buffers, in use or pooled.");
+MetricGauge gamesLoaded("gamebar_games_loaded", "Games in the carousel.");
+static MetricGauge residentMemory("gamebar_resident_memory_bytes", "Process memory in RAM, sampled at export.");
+MetricCounter framesRendered("gamebar_frames_total", "Frames rendered.");
+//in Phase order
+MetricHistogram phaseSeconds[PHASE_COUNT] = {
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"frame\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"events\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"upload\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"render\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"cache\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"schedule\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"live\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"text\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"decode\"" },
+	{ "gamebar_phase_seconds", "Time spent in each instrumented phase.", "phase=\"download\"" }
+};
+MetricHistogram inputLatency[INPUT_SOURCE_COUNT] = {
+	{ "gamebar_input_latency_seconds", "Time from an input event to the first frame presented that shows it.", "source=\"keyboard\"" },
+	{ "gamebar_input_latency_seconds", "Time from an input event to the first frame presented that shows it.", "source=\"keypad\"" },
+	{ "gamebar_input_latency_seconds", "Time from an input event to the first frame presented that shows it.", "source=\"axis\"" },
+	{ "gamebar_input_latency_seconds", "Time from an input event to the first frame presented that shows it.", "source=\"dpad\"" }
+};
+MetricCounter stalls[PHASE_COUNT + 1] = {
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"frame\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"events\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"upload\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"render\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"cache\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"schedule\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"live\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"text\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"decode\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"download\"" },
+	{ "gamebar_stalls_total", "Frames over the stall deadline, by the phase they were stuck in.", "phase=\"none\"" }
+};
+
+static std::string metricsFile;
+static Uint32 lastExport = 0;
+static Socket listener = INVALID_SOCKET;
+static std::string socketPath;
+static std::thread server;
+static std::atomic<bool> serving(false);
+static double ticksPerSecond = (double)SDL_GetPerformanceFrequency();
+
+Metric::Metric(const char* metricName, const char* metricHelp, const char* metricLabels) {
+	name = metricName;
+	help = metricHelp;
+	labels = metricLabels;
+	registry().push_back(this);
+}
+
+const char* Metric::getName() {
+	return name;
+}
+
+const char* Metric::getHelp() {
+	return help;
+}
+
+void Metric::writeSeries(std::string* out, const char* suffix, const char* extra, const char* value) {
+	out->append(name);
+	out->append(suffix);
+	if (labels || extra) {
+		out->push_back('{');
+		if (labels) out->append(labels);
+		if (labels && extra) out->push_back(',');
+		if (extra) out->append(extra);
+		out->push_back('}');
+	}
+	out->push_back(' ');
+	out->append(value);
+	out->push_back('\n');
+}
+
+MetricCounter::MetricCounter(const char* name, const char* help, const char* labels) : Metric(name, help, labels), value(0) {
+}
+
+void MetricCounter::add(uint64_t n) {
+	value.fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t MetricCounter::get() {
+	return value.load(std::memory_order_relaxed);
+}
+
+const char* MetricCounter::getType() {
+	return "counter";
+}
+
+void MetricCounter::write(std::string* out) {
+	char number[32];
+	snprintf(number, sizeof(number), "%llu", (unsigned long long)get());
+	writeSeries(out, "", nullptr, number);
+}
+
+MetricGauge::MetricGauge(const char* name, const char* help, const char* labels) : Metric(name, help, labels), value(0) {
+}
+
+void MetricGauge::set(int64_t n) {
+	value.store(n, std::memory_order_relaxed);
+}
+
+void MetricGauge::add(int64_t n) {
+	value.fetch_add(n, std::memory_order_relaxed);
+}
+
+int64_t MetricGauge::get() {
+	return value.load(std::memory_order_relaxed);
+}
+
+const char* MetricGauge::getType() {
+	return "gauge";
+}
+
+void MetricGauge::write(std::string* out) {
+	char number[32];
+	snprintf(number, sizeof(number), "%lld", (long long)get());
+	writeSeries(out, "", nullptr, number);
+}
+
+MetricHistogram::MetricHistogram(const char* name, const char* help, const char* labels) : Metric(name, help, labels), sumUs(0) {
+	for (auto& bucket : buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+}
+
+void MetricHistogram::observe(double seconds) {
+	int bucket = 0;
+	while (bucket < BUCKET_COUNT && seconds > METRIC_BUCKETS[bucket]) bucket++;
+	buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	sumUs.fetch_add(seconds > 0 ? (uint64_t)(seconds * 1e6) : 0, std::memory_order_relaxed);
+}
+
+void MetricHistogram::observeTicks(Uint64 ticks) {
+	observe(ticks / ticksPerSecond);
+}
+
+const char* MetricHistogram::getType() {
+	return "histogram";
+}
+
+void MetricHistogram::write(std::string* out) {
+	//buckets are counted singly and reported cumulatively; a sample landing meanwhile shows up in the next export
+	char bound[32];
+	char number[32];
+	uint64_t count = 0;
+	for (int bucket = 0; bucket <= BUCKET_COUNT; bucket++) {
+		count += buckets[bucket].load(std::memory_order_relaxed);
+		if (bucket < BUCKET_COUNT) {
+			snprintf(bound, sizeof(bound), "le=\"%g\"", METRIC_BUCKETS[bucket]);
+		}
+		else {
+			snprintf(bound, sizeof(bound), "le=\"+Inf\"");
+		}
+		snprintf(number, sizeof(number), "%llu", (unsigned long long)count);
+		writeSeries(out, "_bucket", bound, number);
+	}
+	snprintf(number, sizeof(number), "%.6f", sumUs.load(std::memory_order_relaxed) / 1e6);
+	writeSeries(out, "_sum", nullptr, number);
+	snprintf(number, sizeof(number), "%llu", (unsigned long long)count);
+	writeSeries(out, "_count", nullptr, number);
+}
+
+//Bytes of the process in RAM, 0 if that can't be told.
+static int64_t sampleResidentMemory() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return (int64_t)counters.WorkingSetSize;
+	}
+	return 0;
+#else
+	long pages = 0, resident = 0;
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (!statm) return 0;
+	if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+	fclose(statm);
+	return (int64_t)resident * sysconf(_SC_PAGESIZE);
+#endif
+}
+
+std::string formatMetrics() {
+	residentMemory.set(sampleResidentMemory());
+	std::string out;
+	out.reserve(16384);
+	const char* previous = nullptr;
+	for (Metric* metric : registry()) {
+		//one HELP and TYPE for all the series of a name
+		if (!previous || strcmp(previous, metric->getName()) != 0) {
+			out.append("# HELP ").append(metric->getName()).append(" ").append(metric->getHelp()).append("\n");
+			out.append("# TYPE ").append(metric->getName()).append(" ").append(metric->getType()).append("\n");
+			previous = metric->getName();
+		}
+		metric->write(&out);
+	}
+	return out;
+}
+
+//Rewrites the metrics file whole, so a scrape never reads it half written.
+static bool writeMetricsFile() {
+	std::string partPath = metricsFile + ".part";
+	FILE* file = fopen(partPath.c_str(), "wb");
+	if (!file) {
+		std::cout << "Error opening file " << partPath << "!" << std::endl;
+		return false;
+	}
+	std::string text = formatMetrics();
+	bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+	written = fclose(file) == 0 && written;
+#ifdef _WIN32
+	written = written && MoveFileExA(partPath.c_str(), metricsFile.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	written = written && rename(partPath.c_str(), metricsFile.c_str()) == 0;
+#endif
+	if (!written) {
+		std::cout << "Error writing metrics " << metricsFile << std::endl;
+		remove(partPath.c_str());
+	}
+	return written;
+}
+
+static bool waitReadable(Socket socket, long us) {
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(socket, &readable);
+	timeval timeout = { us / 1000000, us % 1000000 };
+	return select((int)socket + 1, &readable, nullptr, nullptr, &timeout) > 0;
+}
+
+//Answers every connection with the current figures as an HTTP response, so curl --unix-socket or a scraping
+//agent can ask for them, and closes it. Wakes twice a second to see if it should stop.
+static void serve() {
+	setTraceThreadName("metrics");
+	while (serving) {
+		if (!waitReadable(listener, 500000)) continue;
+		Socket client = accept(listener, nullptr, nullptr);
+		if (client == INVALID_SOCKET) continue;
+		//whatever was asked, once the request is in; a client that sends nothing gets the figures after a second
+		std::string request;
+		char buffer[1024];
+		while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192 && waitReadable(client, 1000000)) {
+			int n = (int)recv(client, buffer, sizeof(buffer), 0);
+			if (n <= 0) break;
+			request.append(buffer, n);
+		}
+		std::string body = formatMetrics();
+		std::string text = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+		size_t sent = 0;
+		while (sent < text.size()) {
+			int n = (int)send(client, text.data() + sent, (int)(text.size() - sent), 0);
+			if (n <= 0) break;
+			sent += n;
+		}
+		closesocket(client);
+	}
+}
+
+bool startMetrics(const std::string& target) {
+	if (target.compare(0, 5, "unix:") != 0) {
+		metricsFile = target;
+		return writeMetricsFile();
+	}
+	socketPath = target.substr(5);
+	sockaddr_un address = {};
+	if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+		std::cout << "Bad metrics socket path " << socketPath << std::endl;
+		return false;
+	}
+#ifdef _WIN32
+	//AF_UNIX needs Windows 10 1803 or later
+	WSADATA wsa;
+	WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+	listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener == INVALID_SOCKET) {
+		std::cout << "Can't create metrics socket" << std::endl;
+		return false;
+	}
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+	//left behind by an earlier run
+	remove(socketPath.c_str());
+	if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 8) != 0) {
+		std::cout << "Can't listen on " << socketPath << std::endl;
+		closesocket(listener);
+		listener = INVALID_SOCKET;
+		return false;
+	}
+	serving = true;
+	server = std::thread(serve);
+	return true;
+}
+
+void exportMetrics(Uint32 now) {
+	if (metricsFile.empty() || now - lastExport < METRICS_EXPORT_MS) return;
+	lastExport = now;
+	writeMetricsFile();
+}
+
+void stopMetrics() {
+	if (!metricsFile.empty()) {
+		writeMetricsFile();
+	}
+	if (serving) {
+		serving = false;
+		server.join();
+		closesocket(listener);
+		listener = INVALID_SOCKET;
+		remove(socketPath.c_str());
+	}
+}
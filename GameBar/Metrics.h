@@ -0,0 +1,128 @@
+#pragma once
+#include "PhaseTimer.h"
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <string>
+
+//Counters, gauges and histograms for fleet monitoring, exported in the Prometheus text format. Updating one is a
+//relaxed atomic add, so they can sit on any thread's hot path; only exporting walks them all.
+//Every metric is defined in Metrics.cpp, where it registers itself, and is exported in the order defined there.
+//Metrics sharing a name (the same figure under different labels) must be defined next to each other.
+
+//Sample of one export target: a counter, a gauge or a histogram series.
+class Metric
+{
+public:
+	//labels are written as is inside the braces, e.g. kind="image"; nullptr for none. All must be string literals
+	Metric(const char* name, const char* help, const char* labels);
+	virtual ~Metric() {}
+
+	const char* getName();
+	const char* getHelp();
+	virtual const char* getType() = 0;
+	//Appends this series' sample lines.
+	virtual void write(std::string* out) = 0;
+
+protected:
+	//name{labels} with extra appended to the labels
+	void writeSeries(std::string* out, const char* suffix, const char* extra, const char* value);
+
+	const char* name;
+	const char* help;
+	const char* labels;
+};
+
+//Only goes up.
+class MetricCounter : public Metric
+{
+public:
+	MetricCounter(const char* name, const char* help, const char* labels = nullptr);
+	void add(uint64_t n = 1);
+	uint64_t get();
+	const char* getType() override;
+	void write(std::string* out) override;
+
+private:
+	std::atomic<uint64_t> value;
+};
+
+//Goes up and down.
+class MetricGauge : public Metric
+{
+public:
+	MetricGauge(const char* name, const char* help, const char* labels = nullptr);
+	void set(int64_t n);
+	void add(int64_t n);
+	int64_t get();
+	const char* getType() override;
+	void write(std::string* out) override;
+
+private:
+	std::atomic<int64_t> value;
+};
+
+//Durations in seconds, counted into METRIC_BUCKETS.
+class MetricHistogram : public Metric
+{
+public:
+	MetricHistogram(const char* name, const char* help, const char* labels = nullptr);
+	void observe(double seconds);
+	//ticks of SDL_GetPerformanceCounter()
+	void observeTicks(Uint64 ticks);
+	const char* getType() override;
+	void write(std::string* out) override;
+
+	static const int BUCKET_COUNT = 16;
+
+private:
+	std::atomic<uint64_t> buckets[BUCKET_COUNT + 1]; //the last one is past every bound
+	std::atomic<uint64_t> sumUs;
+};
+
+enum HttpKind {
+	HTTP_IMAGE,		//downloadFile()
+	HTTP_SCHEDULE,	//downloadString()
+	HTTP_POLL,		//downloadIfChanged()
+	HTTP_STREAM,	//update stream connections
+	HTTP_KIND_COUNT
+};
+
+enum RetryKind {
+	RETRY_DAY,		//a day fetch that failed is tried again after DATE_RETRY_MS
+	RETRY_STREAM,	//a dropped update stream is reconnected after a backoff
+	RETRY_IMAGE,	//an image whose download or decode failed is requested again after a backoff
+	RETRY_KIND_COUNT
+};
+
+extern MetricCounter httpRequests[HTTP_KIND_COUNT];
+//failures only, fetches called off on purpose are counted in httpCancelled
+extern MetricCounter httpFailures[HTTP_KIND_COUNT];
+extern MetricCounter httpCancelled[HTTP_KIND_COUNT];
+extern MetricCounter httpBytes[HTTP_KIND_COUNT];
+extern MetricHistogram httpSeconds[HTTP_KIND_COUNT];
+extern MetricCounter httpRetries[RETRY_KIND_COUNT];
+extern MetricCounter diskCacheHits;
+extern MetricCounter diskCacheMisses;
+extern MetricGauge texturesResident;
+extern MetricGauge textureBytesResident;
+extern MetricGauge decodeBufferBytes;
+extern MetricGauge gamesLoaded;
+extern MetricCounter framesRendered;
+//every PhaseTimer phase, frame and decode among them
+extern MetricHistogram phaseSeconds[PHASE_COUNT];
+//event timestamp to the present that showed it, by input source
+extern MetricHistogram inputLatency[INPUT_SOURCE_COUNT];
+//frames over the watchdog's deadline, by the phase they were stuck in; the last is outside any phase
+extern MetricCounter stalls[PHASE_COUNT + 1];
+
+//Exports to target: a file path is rewritten every METRICS_EXPORT_MS by exportMetrics(), for a textfile
+//collector to pick up; "unix:PATH" listens on that UNIX socket and answers each HTTP request on it with the
+//current figures. Returns false if the target can't be set up.
+bool startMetrics(const std::string& target);
+//Rewrites the metrics file when it is due. Called once a frame.
+void exportMetrics(Uint32 now);
+//Writes the file a last time, or closes the socket.
+void stopMetrics();
+
+//Every metric in the Prometheus text exposition format, process memory sampled as it goes.
+std::string formatMetrics();
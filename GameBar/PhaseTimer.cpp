@@ -0,0 +1,185 @@
+#include "PhaseTimer.h"
+#include "Constants.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "Watchdog.h"
+#include <atomic>
+#include <cstdio>
+
+//Microsecond buckets: exact below 16, then 8 per power of two up to 2^32, so a bucket is at most 1/8 wide.
+static const int EXACT_BUCKETS = 16;
+static const int SUB_BUCKETS = 8;
+static const int BUCKET_COUNT = EXACT_BUCKETS + (32 - 4) * SUB_BUCKETS;
+
+struct Histogram {
+	std::atomic<Uint32> buckets[BUCKET_COUNT];
+	std::atomic<Uint32> count;
+	std::atomic<Uint32> maxUs;
+};
+
+static const char* phaseNames[PHASE_COUNT] = { "frame", "events", "upload", "render", "cache", "schedule", "live", "text", "decode", "download" };
+static const char* inputNames[INPUT_SOURCE_COUNT] = { "keyboard", "keypad", "axis", "dpad" };
+
+//phases, then input sources
+static const int SERIES_COUNT = PHASE_COUNT + INPUT_SOURCE_COUNT;
+
+//two rolling windows, samples go into current; the whole run besides. Zeroed as statics
+static Histogram windows[2][SERIES_COUNT];
+static Histogram run[SERIES_COUNT];
+static std::atomic<int> current(0);
+static Uint32 windowStart = 0;
+static double ticksPerUs = SDL_GetPerformanceFrequency() / 1e6;
+
+static int bucketOf(Uint32 us) {
+	if (us < EXACT_BUCKETS) return (int)us;
+	int power = 31;
+	while (!(us & (1u << power))) power--;
+	int sub = (int)(us >> (power - 3)) & (SUB_BUCKETS - 1);
+	return EXACT_BUCKETS + (power - 4) * SUB_BUCKETS + sub;
+}
+
+//largest value in bucket
+static double bucketTop(int bucket) {
+	if (bucket < EXACT_BUCKETS) return bucket;
+	int power = (bucket - EXACT_BUCKETS) / SUB_BUCKETS + 4;
+	int sub = (bucket - EXACT_BUCKETS) % SUB_BUCKETS;
+	return (double)(((Uint64)(SUB_BUCKETS + sub + 1) << (power - 3)) - 1);
+}
+
+static void add(Histogram& histogram, Uint32 us) {
+	histogram.buckets[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+	histogram.count.fetch_add(1, std::memory_order_relaxed);
+	Uint32 max = histogram.maxUs.load(std::memory_order_relaxed);
+	while (us > max && !histogram.maxUs.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+	}
+}
+
+static void clear(Histogram& histogram) {
+	for (auto& bucket : histogram.buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	histogram.count.store(0, std::memory_order_relaxed);
+	histogram.maxUs.store(0, std::memory_order_relaxed);
+}
+
+//Percentiles over the given histograms taken together, without allocating.
+static PhaseSummary summarize(const Histogram* histograms[], int count) {
+	PhaseSummary summary = {};
+	for (int h = 0; h < count; h++) {
+		summary.count += histograms[h]->count.load(std::memory_order_relaxed);
+		Uint32 max = histograms[h]->maxUs.load(std::memory_order_relaxed);
+		summary.maxUs = max > summary.maxUs ? max : summary.maxUs;
+	}
+	if (summary.count == 0) return summary;
+	double* targets[] = { &summary.p50Us, &summary.p95Us, &summary.p99Us };
+	double ranks[] = { 0.50, 0.95, 0.99 };
+	int next = 0;
+	Uint64 seen = 0;
+	for (int bucket = 0; bucket < BUCKET_COUNT && next < 3; bucket++) {
+		for (int h = 0; h < count; h++) {
+			seen += histograms[h]->buckets[bucket].load(std::memory_order_relaxed);
+		}
+		while (next < 3 && seen > ranks[next] * summary.count) {
+			//never past the largest sample actually seen
+			*targets[next++] = bucketTop(bucket) < summary.maxUs ? bucketTop(bucket) : summary.maxUs;
+		}
+	}
+	//samples racing the walk can leave the top ranks unset
+	for (; next < 3; next++) {
+		*targets[next] = summary.maxUs;
+	}
+	return summary;
+}
+
+const char* phaseName(Phase phase) {
+	return phaseNames[phase];
+}
+
+const char* inputSourceName(InputSource source) {
+	return inputNames[source];
+}
+
+PhaseTimer::PhaseTimer(Phase timedPhase) {
+	phase = timedPhase;
+	outer = enterWatchedPhase(phase);
+	start = SDL_GetPerformanceCounter();
+}
+
+PhaseTimer::~PhaseTimer() {
+	Uint64 end = SDL_GetPerformanceCounter();
+	leaveWatchedPhase(outer);
+	recordPhase(phase, end - start);
+	//part of whatever image request the thread is working on, if any
+	traceSpan("phase", phaseNames[phase], start, end, getTraceFlow());
+}
+
+void recordPhase(Phase phase, Uint64 ticks) {
+	double us = ticks / ticksPerUs;
+	Uint32 clamped = us < 4e9 ? (Uint32)us : 4000000000u;
+	add(windows[current.load(std::memory_order_relaxed)][phase], clamped);
+	add(run[phase], clamped);
+	phaseSeconds[phase].observeTicks(ticks);
+}
+
+void recordInputLatency(InputSource source, Uint32 ms) {
+	Uint32 us = ms < 4000000 ? ms * 1000 : 4000000000u;
+	add(windows[current.load(std::memory_order_relaxed)][PHASE_COUNT + source], us);
+	add(run[PHASE_COUNT + source], us);
+	inputLatency[source].observe(ms / 1000.0);
+}
+
+static PhaseSummary summarizeWindows(int series) {
+	const Histogram* both[] = { &windows[0][series], &windows[1][series] };
+	return summarize(both, 2);
+}
+
+static PhaseSummary summarizeWhole(int series) {
+	const Histogram* whole[] = { &run[series] };
+	return summarize(whole, 1);
+}
+
+PhaseSummary summarizePhase(Phase phase) {
+	return summarizeWindows(phase);
+}
+
+PhaseSummary summarizeRun(Phase phase) {
+	return summarizeWhole(phase);
+}
+
+PhaseSummary summarizeInput(InputSource source) {
+	return summarizeWindows(PHASE_COUNT + source);
+}
+
+PhaseSummary summarizeInputRun(InputSource source) {
+	return summarizeWhole(PHASE_COUNT + source);
+}
+
+void rollPhases(Uint32 now) {
+	if (now - windowStart < PHASE_WINDOW_MS) return;
+	windowStart = now;
+	//the older window is emptied and takes over; a job thread's sample landing mid-switch is at worst lost
+	int older = 1 - current.load(std::memory_order_relaxed);
+	for (auto& histogram : windows[older]) {
+		clear(histogram);
+	}
+	current.store(older, std::memory_order_relaxed);
+}
+
+void printPhaseStats() {
+	printf("Phases (ms):   count      p50      p95      p99      max\n");
+	for (int phase = 0; phase < PHASE_COUNT; phase++) {
+		PhaseSummary summary = summarizeRun((Phase)phase);
+		if (summary.count == 0) continue;
+		printf("  %-10s %8u %8.2f %8.2f %8.2f %8.2f\n", phaseNames[phase], summary.count, summary.p50Us / 1000,
+			summary.p95Us / 1000, summary.p99Us / 1000, summary.maxUs / 1000);
+	}
+	//the event's timestamp is in whole milliseconds
+	printf("Input to photon (ms):\n");
+	for (int source = 0; source < INPUT_SOURCE_COUNT; source++) {
+		PhaseSummary summary = summarizeInputRun((InputSource)source);
+		if (summary.count == 0) continue;
+		printf("  %-10s %8u %8.0f %8.0f %8.0f %8.0f\n", inputNames[source], summary.count, summary.p50Us / 1000,
+			summary.p95Us / 1000, summary.p99Us / 1000, summary.maxUs / 1000);
+	}
+	fflush(stdout);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <SDL2/SDL.h>
+
+//Parts of a frame, and of the work behind it, that are timed. The first few run on the UI thread once per frame;
+//text, decode and download run on job threads, download also wherever a fetch is made.
+enum Phase {
+	PHASE_FRAME = 0,	//the whole loop iteration, without the wait before the next
+	PHASE_EVENTS,		//checkEvents()
+	PHASE_UPLOAD,		//images->update(), finished decodes uploaded
+	PHASE_RENDER,		//renderScene()
+	PHASE_CACHE,		//prefetch windows, checkCache() and warmCache()
+	PHASE_SCHEDULE,		//checkSchedule()
+	PHASE_LIVE,			//refreshLive()
+	PHASE_TEXT,			//rasterizing one game's text
+	PHASE_DECODE,		//decoding one image
+	PHASE_DOWNLOAD,		//one fetch
+	PHASE_COUNT
+};
+
+const char* phaseName(Phase phase);
+
+//Where an input that moved the carousel came from, for input to photon latency.
+enum InputSource {
+	INPUT_KEYBOARD = 0,	//arrows and page keys
+	INPUT_KEYPAD,		//keypad 4 and 6
+	INPUT_AXIS,			//controller left stick
+	INPUT_DPAD,			//controller D-pad
+	INPUT_SOURCE_COUNT
+};
+
+const char* inputSourceName(InputSource source);
+
+//Times the scope it lives in as phase. Costs two SDL_GetPerformanceCounter() calls and a few atomic adds, and
+//a trace span while tracing (Trace.h).
+class PhaseTimer
+{
+public:
+	explicit PhaseTimer(Phase phase);
+	~PhaseTimer();
+	PhaseTimer(const PhaseTimer&) = delete;
+	PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+	Phase phase;
+	Phase outer; //phase the watched thread goes back to, see Watchdog.h
+	Uint64 start;
+};
+
+//Adds one sample of phase taking ticks (SDL_GetPerformanceCounter() units). Safe from any thread.
+void recordPhase(Phase phase, Uint64 ticks);
+//Adds one input taking ms from its event's timestamp to the SDL_RenderPresent() that first showed it.
+void recordInputLatency(InputSource source, Uint32 ms);
+
+//Percentiles of a phase over the last PHASE_WINDOW_MS to twice that, in microseconds. Each is the top of
+//the histogram bucket it falls in, so within 1/8 of the true value.
+struct PhaseSummary {
+	Uint32 count;
+	double p50Us;
+	double p95Us;
+	double p99Us;
+	double maxUs;
+};
+
+PhaseSummary summarizePhase(Phase phase);
+//The same over the whole run.
+PhaseSummary summarizeRun(Phase phase);
+//The same for input latencies.
+PhaseSummary summarizeInput(InputSource source);
+PhaseSummary summarizeInputRun(InputSource source);
+
+//Starts a new window of samples once the current one is PHASE_WINDOW_MS old, forgetting the one before.
+//Call once per frame from the UI thread.
+void rollPhases(Uint32 now);
+
+//Prints every phase's and input source's whole run summary to stdout.
+void printPhaseStats();
@@ -0,0 +1,99 @@
+#include "PollingUpdateSource.h"
+#include "DateIndex.h"
+#include "Download.h"
+#include <chrono>
+#include <iostream>
+
+PollingUpdateSource::PollingUpdateSource(JobSystem* jobSystem, std::string url, Uint32 intervalMs) {
+	jobs = jobSystem;
+	baseUrl = url;
+	interval = intervalMs;
+	nextPollAt = SDL_GetTicks() + interval;
+	inFlight = 0;
+	failedRounds = 0;
+	roundFailed = false;
+	notModified = 0;
+	rounds = 0;
+}
+
+void PollingUpdateSource::watch(int firstDay, int lastDay) {
+	//keep the validators of days still followed
+	for (auto it = days.begin(); it != days.end();) {
+		if (it->first.first < firstDay || it->first.first > lastDay) {
+			it = days.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	for (int day = firstDay; day <= lastDay; day++) {
+		for (int feed = 0; feed < FEED_COUNT; feed++) {
+			std::shared_ptr<DayPoll>& poll = days[std::make_pair(day, feed)];
+			if (!poll) {
+				poll = std::make_shared<DayPoll>();
+				poll->day = day;
+				poll->feed = feed;
+			}
+		}
+	}
+}
+
+void PollingUpdateSource::update(Uint32 now) {
+	if (interval == 0 || days.empty() || (int)(now - nextPollAt) < 0 || inFlight > 0) return;
+	if (rounds > 0) {
+		failedRounds = roundFailed ? failedRounds + 1 : 0;
+	}
+	roundFailed = false;
+	rounds++;
+	nextPollAt = now + interval;
+	for (auto& entry : days) {
+		std::shared_ptr<DayPoll> day = entry.second;
+		inFlight++;
+		jobs->run(JOB_PRIORITY_LOW, [this, day]() {
+			FeedStats& stats = feedStats[day->feed];
+			auto batch = std::make_shared<ScheduleBatch>();
+			batch->day = day->day;
+			batch->feed = day->feed;
+			batch->refresh = true;
+			auto start = std::chrono::steady_clock::now();
+			long status = downloadIfChanged(feedUrl(baseUrl, day->feed, day->day), &day->etag, &batch->response);
+			batch->receivedAt = SDL_GetPerformanceCounter();
+			auto fetchedAt = std::chrono::steady_clock::now();
+			stats.fetches++;
+			stats.fetchMicros += std::chrono::duration_cast<std::chrono::microseconds>(fetchedAt - start).count();
+			stats.bytes += batch->response.size();
+			if (status == 304) {
+				notModified++;
+			}
+			else if (status == 200 && scanBatch(batch.get())) {
+				stats.parseMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - fetchedAt).count();
+				batch->ok = true;
+				finished.push(batch);
+			}
+			else {
+				stats.failures++;
+				roundFailed = true;
+			}
+			inFlight--;
+		});
+	}
+}
+
+bool PollingUpdateSource::poll(std::shared_ptr<ScheduleBatch>* batch) {
+	return finished.pop(batch);
+}
+
+bool PollingUpdateSource::isHealthy() {
+	return interval > 0 && failedRounds < 3;
+}
+
+const char* PollingUpdateSource::getName() {
+	return "polling";
+}
+
+void PollingUpdateSource::printStats() {
+	std::cout << "Update polling: " << rounds << " rounds, " << notModified << " fetches not modified" << std::endl;
+	for (int feed = 0; feed < FEED_COUNT; feed++) {
+		feedStats[feed].print("Update polling", feed);
+	}
+}
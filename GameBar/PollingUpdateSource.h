@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include "JobSystem.h"
+#include "LockFreeQueue.h"
+#include "UpdateSource.h"
+
+//Polls each followed day's schedule, per feed, on an interval with conditional GETs. A day whose ETag still matches
+//comes back as 304 and costs no body and no parse; servers without ETags are simply fetched in full, and
+//unchanged games are then skipped on their fingerprints. Fetches run as jobs.
+class PollingUpdateSource : public UpdateSource
+{
+public:
+	//Polls feedUrl(url, feed, day) every intervalMs, never if it is 0. jobSystem must be stopped before the source is destroyed.
+	PollingUpdateSource(JobSystem* jobSystem, std::string url, Uint32 intervalMs);
+
+	void watch(int firstDay, int lastDay) override;
+	void update(Uint32 now) override;
+	bool poll(std::shared_ptr<ScheduleBatch>* batch) override;
+	bool isHealthy() override;
+	const char* getName() override;
+	void printStats() override;
+
+private:
+	//a followed day's validator for one feed, only touched by its own fetch while one is in flight
+	struct DayPoll {
+		int day;
+		int feed;
+		std::string etag;
+	};
+
+	JobSystem* jobs;
+	std::string baseUrl;
+	Uint32 interval;
+	Uint32 nextPollAt;
+	//by (day, feed)
+	std::map<std::pair<int, int>, std::shared_ptr<DayPoll>> days;
+	MpscQueue<std::shared_ptr<ScheduleBatch>> finished;
+	//a new round starts only once the last one has finished
+	std::atomic<int> inFlight;
+	std::atomic<int> failedRounds;
+	std::atomic<bool> roundFailed;
+	std::atomic<int> notModified;
+	FeedStats feedStats[FEED_COUNT];
+	int rounds;
+};
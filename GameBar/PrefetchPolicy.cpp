@@ -0,0 +1,178 @@
+#include "PrefetchPolicy.h"
+#include "Constants.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//moves further apart than this are separate gestures, not one scroll
+static const Uint32 SCROLL_GAP_MS = 1000;
+
+bool IndexRange::contains(int index) const {
+	return index >= first && index <= last;
+}
+
+bool IndexRange::operator==(const IndexRange& other) const {
+	return first == other.first && last == other.last;
+}
+
+bool IndexRange::operator!=(const IndexRange& other) const {
+	return !(*this == other);
+}
+
+IndexRange IndexRange::shifted(int offset) const {
+	IndexRange range;
+	range.first = first + offset;
+	range.last = last + offset;
+	return range;
+}
+
+PrefetchPolicy::PrefetchPolicy() {
+	direction = 1;
+	speed = 0;
+	lastMove = 0;
+	lastWarm = 0;
+	count = 0;
+	lastFirstDisplayed = -1;
+	warmAhead = warmBehind = -1;
+	warmTurn = 0;
+	arrivals = hits = 0;
+}
+
+void PrefetchPolicy::onMove(int moveDirection, Uint32 now) {
+	Uint32 gap = now - lastMove;
+	if (lastMove != 0 && moveDirection == direction && gap < SCROLL_GAP_MS) {
+		//smooth over key repeat jitter
+		float instant = 1000.0f / std::max<Uint32>(gap, 1);
+		speed = speed == 0 ? instant : speed * 0.5f + instant * 0.5f;
+	}
+	else {
+		//a single step, or a change of direction, says little about speed yet
+		speed = 0;
+	}
+	direction = moveDirection;
+	lastMove = now;
+}
+
+float PrefetchPolicy::getSpeed(Uint32 now) {
+	if (lastMove == 0 || now - lastMove >= SCROLL_GAP_MS) {
+		return 0;
+	}
+	return speed;
+}
+
+bool PrefetchPolicy::update(int firstDisplayed, int gameCount, Uint32 now) {
+	count = gameCount;
+	float currentSpeed = getSpeed(now);
+	int loadAhead = PREFETCH_LOAD_MARGIN + std::min(PREFETCH_MAX_LOAD_AHEAD, (int)std::ceil(currentSpeed * PREFETCH_LOAD_LEAD_SECONDS));
+	int cacheAhead = PREFETCH_CACHE_MARGIN + std::min(PREFETCH_MAX_CACHE_AHEAD, (int)std::ceil(currentSpeed * PREFETCH_CACHE_LEAD_SECONDS));
+	//while scrolling, what is behind is leaving; keep just enough to turn around
+	int loadBehind = currentSpeed > 0 ? 0 : PREFETCH_LOAD_MARGIN;
+	int cacheBehind = currentSpeed > 0 ? 1 : PREFETCH_CACHE_MARGIN;
+
+	int lastDisplayed = firstDisplayed + GAMES_ON_SCREEN - 1;
+	IndexRange load, cache;
+	if (direction > 0) {
+		load.first = firstDisplayed - loadBehind;
+		load.last = lastDisplayed + loadAhead;
+		cache.first = firstDisplayed - cacheBehind;
+		cache.last = lastDisplayed + cacheAhead;
+	}
+	else {
+		load.first = firstDisplayed - loadAhead;
+		load.last = lastDisplayed + loadBehind;
+		cache.first = firstDisplayed - cacheAhead;
+		cache.last = lastDisplayed + cacheBehind;
+	}
+	load.first = std::max(load.first, 0);
+	load.last = std::min(load.last, count - 1);
+	cache.first = std::max(cache.first, 0);
+	cache.last = std::min(cache.last, count - 1);
+	//when the scroll stops in place, files already fetched ahead are kept rather than deleted and warmed again
+	if (firstDisplayed == lastFirstDisplayed && cacheWindow.last >= cacheWindow.first) {
+		cache.first = std::min(cache.first, cacheWindow.first);
+		cache.last = std::max(cache.last, cacheWindow.last);
+	}
+	lastFirstDisplayed = firstDisplayed;
+
+	bool changed = load != loadWindow || cache != cacheWindow;
+	if (cache != cacheWindow) {
+		//start warming again from the new window's edges
+		if (direction > 0) {
+			warmAhead = cache.last + 1;
+			warmBehind = cache.first - 1;
+		}
+		else {
+			warmAhead = cache.first - 1;
+			warmBehind = cache.last + 1;
+		}
+	}
+	loadWindow = load;
+	cacheWindow = cache;
+	return changed;
+}
+
+void PrefetchPolicy::shift(int offset) {
+	loadWindow = loadWindow.shifted(offset);
+	cacheWindow = cacheWindow.shifted(offset);
+	if (lastFirstDisplayed >= 0) {
+		lastFirstDisplayed += offset;
+	}
+	warmAhead += offset;
+	warmBehind += offset;
+}
+
+IndexRange PrefetchPolicy::getLoadWindow() {
+	return loadWindow;
+}
+
+IndexRange PrefetchPolicy::getCacheWindow() {
+	return cacheWindow;
+}
+
+int PrefetchPolicy::nextWarm(bool screenLoaded, Uint32 now) {
+	if (!screenLoaded || now - lastMove < PREFETCH_IDLE_MS || now - lastWarm < PREFETCH_WARM_INTERVAL_MS) {
+		return -1;
+	}
+	bool aheadLeft = warmAhead >= 0 && warmAhead < count;
+	bool behindLeft = warmBehind >= 0 && warmBehind < count;
+	//two ahead for every one behind
+	warmTurn++;
+	if (aheadLeft && (!behindLeft || warmTurn % 3 != 0)) {
+		int index = warmAhead;
+		warmAhead += direction;
+		return index;
+	}
+	if (behindLeft) {
+		int index = warmBehind;
+		warmBehind -= direction;
+		return index;
+	}
+	return -1;
+}
+
+void PrefetchPolicy::warmStarted(Uint32 now) {
+	lastWarm = now;
+}
+
+void PrefetchPolicy::recordArrival(bool resident) {
+	arrivals++;
+	if (resident) {
+		hits++;
+	}
+}
+
+int PrefetchPolicy::getArrivals() {
+	return arrivals;
+}
+
+int PrefetchPolicy::getHits() {
+	return hits;
+}
+
+void PrefetchPolicy::printStats() {
+	std::cout << "Prefetch: " << hits << " of " << arrivals << " games loaded when scrolled into view";
+	if (arrivals > 0) {
+		std::cout << " (" << (hits * 100 / arrivals) << "% hit rate)";
+	}
+	std::cout << std::endl;
+}
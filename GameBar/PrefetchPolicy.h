@@ -0,0 +1,67 @@
+#pragma once
+#include <SDL2/SDL.h>
+
+//Inclusive range of game indices, empty when last < first.
+struct IndexRange {
+	int first = 0;
+	int last = -1;
+
+	bool contains(int index) const;
+	bool operator==(const IndexRange& other) const;
+	bool operator!=(const IndexRange& other) const;
+	IndexRange shifted(int offset) const;
+};
+
+//Decides which games around the screen have their textures loaded and their files cached. While scrolling,
+//the windows stretch ahead in proportion to the scroll speed and shrink behind; standing still they are
+//symmetric. After a while without input the rest of the day is warmed onto disk one game at a time, and only
+//while everything on screen has finished loading. Times are milliseconds on one clock of the caller's choosing,
+//SDL_GetTicks() or a replayed script's, never 0.
+class PrefetchPolicy
+{
+public:
+	PrefetchPolicy();
+
+	//Records the selection moving by direction (+1 right, -1 left).
+	void onMove(int direction, Uint32 now);
+
+	//Recomputes the windows for a screen starting at firstDisplayed in a list of count games.
+	//Returns true if either window changed.
+	bool update(int firstDisplayed, int count, Uint32 now);
+
+	//Moves the windows by offset after games were inserted (offset > 0) or removed (offset < 0) before them.
+	void shift(int offset);
+
+	IndexRange getLoadWindow();
+	IndexRange getCacheWindow();
+
+	//Returns the next game to warm, or -1 if it isn't time to. Games are offered outward from the cache
+	//window, ahead of the last scroll direction first. Call warmStarted() once one is actually requested.
+	int nextWarm(bool screenLoaded, Uint32 now);
+	void warmStarted(Uint32 now);
+
+	//Records whether a game that just scrolled into view already had its texture.
+	void recordArrival(bool resident);
+
+	//moves per second, 0 once the user has stopped
+	float getSpeed(Uint32 now);
+	int getArrivals();
+	int getHits();
+	void printStats();
+
+private:
+	int direction;
+	float speed;
+	Uint32 lastMove;
+	Uint32 lastWarm;
+	int count;
+	int lastFirstDisplayed;
+	IndexRange loadWindow;
+	IndexRange cacheWindow;
+	//next games outside the cache window to warm, ahead of and behind the scroll direction
+	int warmAhead;
+	int warmBehind;
+	int warmTurn;
+	int arrivals;
+	int hits;
+};
@@ -1,17 +1,29 @@
 #include "RenderEngine.h"
 #include "Constants.h"
+#include "PhaseTimer.h"
+#include "Watchdog.h"
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
 
-RenderEngine::RenderEngine() {
-	win = SDL_CreateWindow("Hello World!", 0, 0, 1920, 1080, SDL_WINDOW_FULLSCREEN || SDL_WINDOW_SHOWN);
+RenderEngine::RenderEngine(JobSystem* jobSystem, bool headless) {
+	jobs = jobSystem;
+	frameCount = 0;
+	textGeneration = 0;
+	frameComplete = false;
+
+	//desktop fullscreen at the panel's native resolution; the layout below is in 1080p units and scaled by SDL.
+	//Headless is exactly 1080p so captured frames are the same size everywhere, and unpaced by vsync
+	Uint32 windowFlags = headless ? SDL_WINDOW_HIDDEN : SDL_WINDOW_FULLSCREEN_DESKTOP | SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI;
+	Uint32 rendererFlags = headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
+	win = SDL_CreateWindow("Hello World!", 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, windowFlags);
 	if (win == nullptr) {
 		std::cout << "SDL_CreateWindow Error: " << SDL_GetError() << std::endl;
 		SDL_Quit();
 		return;
 	}
-	ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+	ren = SDL_CreateRenderer(win, -1, rendererFlags);
 	if (ren == nullptr) {
 		SDL_DestroyWindow(win);
 		std::cout << "SDL_CreateRenderer Error: " << SDL_GetError() << std::endl;
@@ -19,6 +31,20 @@ RenderEngine::RenderEngine() {
 		return;
 	}
 
+	SDL_RenderSetLogicalSize(ren, SCREEN_WIDTH, SCREEN_HEIGHT);
+	//output pixels per layout pixel, used to pick image cuts that stay sharp
+	displayScale = 1;
+	int outputWidth, outputHeight;
+	if (SDL_GetRendererOutputSize(ren, &outputWidth, &outputHeight) == 0) {
+		displayScale = std::min((float)outputWidth / SCREEN_WIDTH, (float)outputHeight / SCREEN_HEIGHT);
+	}
+
+	//game images are recycled through the pool rather than created per load
+	texPool = new TexturePool(ren);
+
+	//phase timings over the scene, off until toggled
+	hud = new Hud(ren);
+
 	//load fonts
 	gameFontSmall = TTF_OpenFont(fontFile.c_str(), gameFontSmallSize);
 	gameFontLarge = TTF_OpenFont(fontFile.c_str(), gameFontLargeSize);
@@ -56,6 +82,23 @@ RenderEngine::~RenderEngine() {
 	//unload background image
 	SDL_DestroyTexture(bgTex);
 
+	delete hud;
+
+	//destroy pooled game textures
+	texPool->printStats();
+	delete texPool;
+
+	//destroy cached text, including any a text job finished after its game was evicted
+	for (auto& entry : textCache) {
+		SDL_DestroyTexture(entry.second.top);
+		SDL_DestroyTexture(entry.second.bottom);
+	}
+	TextRender text;
+	while (finishedText.pop(&text)) {
+		SDL_FreeSurface(text.top);
+		SDL_FreeSurface(text.bottom);
+	}
+
 	//destroy fonts
 	TTF_CloseFont(gameFontSmall);
 	TTF_CloseFont(gameFontLarge);
@@ -67,7 +110,11 @@ RenderEngine::~RenderEngine() {
 	SDL_DestroyWindow(win);
 }
 
-void RenderEngine::renderScene(int firstIndex, int selectedIndex, std::vector<Game>* games) {
+void RenderEngine::renderScene(int firstIndex, int selectedIndex, GameStore* games) {
+	frameCount++;
+	collectText();
+	frameComplete = true;
+
 	SDL_RenderClear(ren);
 
 	//background
@@ -88,19 +135,35 @@ void RenderEngine::renderScene(int firstIndex, int selectedIndex, std::vector<Ga
 	box.h = LARGE_IMAGE_HEIGHT;
 	box.x = 60;
 	box.y = CENTERLINE - (LARGE_IMAGE_HEIGHT / 2);
-	for (int i = firstIndex; i < firstIndex + GAMES_ON_SCREEN; i++) {
-		renderGame(&((*games)[i]), i == selectedIndex, box);
+	for (int i = firstIndex; i < firstIndex + GAMES_ON_SCREEN && i < games->size(); i++) {
+		Game game = (*games)[i];
+		setWatchedGame(game.getId());
+		renderGame(&game, i == selectedIndex, box);
 		//move box over to next even spacing. (Screen width minus both arrows) divided by number of games.
 		box.x += (1920 - 120) / GAMES_ON_SCREEN;
 	}
+	setWatchedGame(-1);
 
+	//read back before presenting, after which the back buffer is undefined
+	if (!capturePath.empty() && frameComplete) {
+		saveCapture();
+	}
+	//after the capture, so golden frames never have it
+	hud->draw();
 	//Update the screen
 	SDL_RenderPresent(ren);
 };
 
 void RenderEngine::renderGame(Game* game, bool selected, SDL_Rect box) {
-	SDL_Texture* imgTex = game->getImage();
-	if (!imgTex) return;
+	SDL_Texture* imgTex = game->getImage(selected);
+	if (!imgTex) {
+		frameComplete = false;
+		return;
+	}
+	//still the small cut, which a capture would keep or not depending on timing
+	if (selected && game->isUpgrading()) {
+		frameComplete = false;
+	}
 	if (selected) {
 		//Draw outer selection box and full size image
 		SDL_Rect outer_rect;
@@ -114,27 +177,29 @@ void RenderEngine::renderGame(Game* game, bool selected, SDL_Rect box) {
 		int x_center = box.x + (box.w / 2);
 
 		SDL_RenderCopy(ren, imgTex, NULL, &box);
-		//Draw text renders
+		//Draw text renders, once a job has rasterized them
+		SDL_Texture *topTextTex, *botTextTex;
+		if (!getText(game, &topTextTex, &botTextTex)) {
+			frameComplete = false;
+			return;
+		}
 		//Top Text box contains titleText in large font, is located 5 pixels above and centered over outer_rect 
-		SDL_Surface *topText = TTF_RenderText_Blended_Wrapped(gameFontLarge, game->getTopText().c_str(), uiColor, box.w);
-		topTextTex = SDL_CreateTextureFromSurface(ren, topText);
-		SDL_FreeSurface(topText);
-		SDL_Rect topTextBox;
-		SDL_QueryTexture(topTextTex, NULL, NULL, &topTextBox.w, &topTextBox.h);
-		topTextBox.x = x_center - (topTextBox.w / 2);
-		topTextBox.y = outer_rect.y - topTextBox.h - 5;
-		SDL_RenderCopy(ren, topTextTex, NULL, &topTextBox);
+		if (topTextTex) {
+			SDL_Rect topTextBox;
+			SDL_QueryTexture(topTextTex, NULL, NULL, &topTextBox.w, &topTextBox.h);
+			topTextBox.x = x_center - (topTextBox.w / 2);
+			topTextBox.y = outer_rect.y - topTextBox.h - 5;
+			SDL_RenderCopy(ren, topTextTex, NULL, &topTextBox);
+		}
 
 		//Bottom Text box contains description text in small font, is located 5 pixels below and centered under outer_rect 
-
-		SDL_Surface *botText = TTF_RenderText_Blended_Wrapped(gameFontSmall, game->getBottomText().c_str(), uiColor, box.w);
-		botTextTex = SDL_CreateTextureFromSurface(ren, botText);
-		SDL_FreeSurface(botText);
-		SDL_Rect botTextBox;
-		SDL_QueryTexture(botTextTex, NULL, NULL, &botTextBox.w, &botTextBox.h);
-		botTextBox.x = x_center - (botTextBox.w / 2);
-		botTextBox.y = outer_rect.y + outer_rect.h + 5;
-		SDL_RenderCopy(ren, botTextTex, NULL, &botTextBox);
+		if (botTextTex) {
+			SDL_Rect botTextBox;
+			SDL_QueryTexture(botTextTex, NULL, NULL, &botTextBox.w, &botTextBox.h);
+			botTextBox.x = x_center - (botTextBox.w / 2);
+			botTextBox.y = outer_rect.y + outer_rect.h + 5;
+			SDL_RenderCopy(ren, botTextTex, NULL, &botTextBox);
+		}
 	}
 	else {
 		//make smaller box to hold smaller image
@@ -148,6 +213,126 @@ void RenderEngine::renderGame(Game* game, bool selected, SDL_Rect box) {
 	return;
 }
 
+bool RenderEngine::getText(Game* game, SDL_Texture** top, SDL_Texture** bottom) {
+	int id = game->getId();
+	auto existing = textCache.find(id);
+	if (existing != textCache.end()) {
+		TextEntry& entry = existing->second;
+		entry.lastUsed = frameCount;
+		//the game's strings changed: rasterize them again, showing the old text until the new arrives
+		if (entry.stale) {
+			entry.stale = false;
+			requestText(game, &entry);
+		}
+		*top = entry.top;
+		*bottom = entry.bottom;
+		return entry.ready;
+	}
+
+	TextEntry& entry = textCache[id];
+	entry.lastUsed = frameCount;
+	requestText(game, &entry);
+
+	//keep the cache to roughly a screen's worth of games
+	if (textCache.size() > GAMES_ON_SCREEN) {
+		auto oldest = textCache.begin();
+		for (auto it = textCache.begin(); it != textCache.end(); ++it) {
+			if (it->second.lastUsed < oldest->second.lastUsed) oldest = it;
+		}
+		SDL_DestroyTexture(oldest->second.top);
+		SDL_DestroyTexture(oldest->second.bottom);
+		textCache.erase(oldest);
+	}
+	return false;
+}
+
+void RenderEngine::requestText(Game* game, TextEntry* entry) {
+	int id = game->getId();
+	entry->generation = ++textGeneration;
+	entry->pending = true;
+	Uint32 generation = entry->generation;
+	std::string topText = game->getTopText();
+	std::string bottomText = game->getBottomText();
+	jobs->run(JOB_PRIORITY_HIGH, [this, id, generation, topText, bottomText]() {
+		TextRender text;
+		text.gameId = id;
+		text.generation = generation;
+		{
+			std::lock_guard<std::mutex> guard(fontLock);
+			PhaseTimer timer(PHASE_TEXT);
+			text.top = TTF_RenderText_Blended_Wrapped(gameFontLarge, topText.c_str(), uiColor, LARGE_IMAGE_WIDTH);
+			text.bottom = TTF_RenderText_Blended_Wrapped(gameFontSmall, bottomText.c_str(), uiColor, LARGE_IMAGE_WIDTH);
+		}
+		finishedText.push(text);
+	});
+}
+
+void RenderEngine::collectText() {
+	TextRender text;
+	while (finishedText.pop(&text)) {
+		auto found = textCache.find(text.gameId);
+		if (found != textCache.end() && found->second.pending && found->second.generation == text.generation) {
+			TextEntry& entry = found->second;
+			//swap out the text this replaces, if any
+			SDL_DestroyTexture(entry.top);
+			SDL_DestroyTexture(entry.bottom);
+			//TTF gives back no surface for empty text
+			entry.top = text.top ? SDL_CreateTextureFromSurface(ren, text.top) : nullptr;
+			entry.bottom = text.bottom ? SDL_CreateTextureFromSurface(ren, text.bottom) : nullptr;
+			entry.ready = true;
+			entry.pending = false;
+		}
+		SDL_FreeSurface(text.top);
+		SDL_FreeSurface(text.bottom);
+	}
+}
+
 SDL_Renderer* RenderEngine::getRenderer() {
 	return ren;
+}
+
+TexturePool* RenderEngine::getTexturePool() {
+	return texPool;
+}
+
+float RenderEngine::getDisplayScale() {
+	return displayScale;
+}
+
+void RenderEngine::invalidateText(int gameId) {
+	auto entry = textCache.find(gameId);
+	if (entry == textCache.end()) return;
+	//the textures stay on screen until the game is next drawn and its new text is rasterized
+	entry->second.stale = true;
+}
+
+bool RenderEngine::isTextPending() {
+	for (auto& entry : textCache) {
+		if (entry.second.lastUsed == frameCount && entry.second.pending) return true;
+	}
+	return false;
+}
+
+void RenderEngine::captureFrame(const std::string& path) {
+	capturePath = path;
+}
+
+bool RenderEngine::isCapturePending() {
+	return !capturePath.empty();
+}
+
+void RenderEngine::toggleHud() {
+	hud->toggle();
+}
+
+void RenderEngine::saveCapture() {
+	int width, height;
+	SDL_GetRendererOutputSize(ren, &width, &height);
+	SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+	if (!frame || SDL_RenderReadPixels(ren, NULL, SDL_PIXELFORMAT_ARGB8888, frame->pixels, frame->pitch) != 0 ||
+		IMG_SavePNG(frame, capturePath.c_str()) != 0) {
+		std::cout << "Error saving frame " << capturePath << ": " << SDL_GetError() << std::endl;
+	}
+	SDL_FreeSurface(frame);
+	capturePath.clear();
 }
\ No newline at end of file
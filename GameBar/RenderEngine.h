@@ -2,24 +2,94 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
-#include "Game.h"
+#include <map>
+#include <mutex>
+#include "GameStore.h"
+#include "Hud.h"
+#include "JobSystem.h"
+#include "LockFreeQueue.h"
+#include "TexturePool.h"
+
+//Rasterized title and description for one game, handed from a text job to the render thread.
+struct TextRender {
+	int gameId = 0;
+	//which request this answers, so a render superseded by a later one is ignored
+	Uint32 generation = 0;
+	SDL_Surface* top = nullptr;
+	SDL_Surface* bottom = nullptr;
+};
 
 class RenderEngine
 {
 public:
-	RenderEngine();
+	//Text is rasterized by jobs on jobSystem, which must be stopped before the engine is destroyed.
+	//Headless draws into a hidden 1080p window with the software renderer, for SDL's dummy video driver.
+	RenderEngine(JobSystem* jobSystem, bool headless = false);
 	~RenderEngine();
-	void renderScene(int firstIndex, int selectedIndex, std::vector<Game> *games);
+	void renderScene(int firstIndex, int selectedIndex, GameStore *games);
 	SDL_Renderer* getRenderer();
+	TexturePool* getTexturePool();
+	//output pixels per layout pixel: 1 on a 1080p panel, 2 on 4K
+	float getDisplayScale();
+	//Has game gameId's text rasterized again from its current strings the next time it is drawn. The old text
+	//is drawn until the new is ready.
+	void invalidateText(int gameId);
+	//Whether the last frame drew any game with text still being rasterized, old or none at all in its place.
+	bool isTextPending();
+	//Saves the next frame that shows every on-screen game's image and text to path, as a PNG.
+	void captureFrame(const std::string& path);
+	bool isCapturePending();
+	//Shows or hides the phase timing overlay.
+	void toggleHud();
 private:
+	struct TextEntry {
+		SDL_Texture* top = nullptr;
+		SDL_Texture* bottom = nullptr;
+		bool ready = false;
+		//a job for generation is in flight
+		bool pending = false;
+		//invalidated, a new job is queued the next time the game is drawn
+		bool stale = false;
+		Uint32 lastUsed = 0;
+		Uint32 generation = 0;
+	};
+
 	void renderGame(Game* game, bool selected, SDL_Rect box);
 
+	//Looks up game's text textures, queueing a job to rasterize them on first use. Returns false until they're ready.
+	//Either texture may be null if its text was empty.
+	bool getText(Game* game, SDL_Texture** top, SDL_Texture** bottom);
+
+	//Queues a job rasterizing game's current text for entry, under a new generation.
+	void requestText(Game* game, TextEntry* entry);
+
+	//Turns finished text jobs into textures, replacing any older text they were queued to update.
+	void collectText();
+
+	//Reads back what was drawn this frame into capturePath.
+	void saveCapture();
+
 	SDL_Window *win;
 	SDL_Renderer *ren;
+	TexturePool *texPool;
+	Hud *hud;
+	float displayScale;
 	SDL_Texture *bgTex;
 	SDL_Texture *leftTex, *rightTex;
-	SDL_Texture *botTextTex, *topTextTex;
 	SDL_Rect leftRect, rightRect;
 	TTF_Font *gameFontSmall, *gameFontLarge;
+
+	JobSystem* jobs;
+	//text textures by game id, the least recently drawn are dropped beyond GAMES_ON_SCREEN entries
+	std::map<int, TextEntry> textCache;
+	MpscQueue<TextRender> finishedText;
+	//fonts aren't thread safe, text jobs take turns with them
+	std::mutex fontLock;
+	Uint32 frameCount;
+	Uint32 textGeneration;
+	//whether this frame drew everything on screen, nothing still loading
+	bool frameComplete;
+	//frame to save, none if empty
+	std::string capturePath;
 };
 
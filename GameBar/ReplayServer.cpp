@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <curl/curl.h>
+#include "HttpStub.h"
+
+//Standalone stand-in for every server GameBar talks to, so startup and scrolling can be measured offline and
+//under a bad network. Run GameBar with --origin http://localhost:8090 and each fetch of scheme://host/path
+//arrives here as /scheme/host/path (see setOrigin()).
+//  --record DIR    fetch what isn't recorded yet from the real server and keep it in DIR
+//  --replay DIR    serve only what DIR holds, 404 for the rest (the default, with DIR "recorded")
+//Faults, applied to every response, or only those whose url contains --match:
+//  --latency MS, --jitter MS         wait before answering, plus up to jitter more
+//  --bandwidth KBPS                  cap each response's transfer rate, in kilobits per second
+//  --stall-rate P, --stall-ms MS     chance a response stops halfway through for MS
+//  --error-rate P                    chance of a 503 instead
+//  --reset-rate P                    chance the connection is closed halfway through the body
+//  --profile 3g|flaky-cdn            presets for the above: a congested venue link, or an image CDN that misbehaves
+//  --seed N                          for the fault dice. A response's faults follow from the seed, its url and how
+//                                    many times that url was asked for before, so concurrent runs repeat too
+//A recorded response has an ETag from its body, and If-None-Match gets a 304, as statsapi's would.
+//Usage: ReplayServer [port] [options]. DIR holds one .body file per url and index.tsv naming them.
+
+struct Faults {
+	int latencyMs = 0;
+	int jitterMs = 0;
+	int bandwidthKbps = 0;
+	double stallRate = 0;
+	int stallMs = 0;
+	double errorRate = 0;
+	double resetRate = 0;
+	std::string match;
+};
+
+struct Recording {
+	long status = 0;
+	std::string contentType;
+	std::string file;
+};
+
+std::mutex stateLock;
+//by url, scheme://host/path
+std::map<std::string, Recording> recordings;
+std::string directory = "recorded";
+bool recording = false;
+Faults faults;
+unsigned seed = 0;
+//requests answered so far, by url
+std::map<std::string, uint64_t> requestCounts;
+
+//FNV-1a
+uint64_t hash64(const std::string& s) {
+	uint64_t hash = 14695981039346656037ull;
+	for (char c : s) {
+		hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+	}
+	return hash;
+}
+
+std::string hashHex(const std::string& s) {
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash64(s));
+	return hex;
+}
+
+//index.tsv: one "file<TAB>status<TAB>content type<TAB>url" line per recording
+void loadIndex() {
+	std::ifstream index(directory + "/index.tsv");
+	std::string line;
+	while (std::getline(index, line)) {
+		std::istringstream fields(line);
+		Recording recorded;
+		std::string status, url;
+		if (std::getline(fields, recorded.file, '\t') && std::getline(fields, status, '\t') &&
+			std::getline(fields, recorded.contentType, '\t') && std::getline(fields, url)) {
+			recorded.status = atol(status.c_str());
+			recordings[url] = recorded;
+		}
+	}
+	std::cout << recordings.size() << " recorded responses in " << directory << std::endl;
+}
+
+bool readFile(const std::string& path, std::string* out) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+	out->assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return true;
+}
+
+size_t appendBody(char* ptr, size_t size, size_t nmemb, void* out) {
+	((std::string*)out)->append(ptr, size * nmemb);
+	return size * nmemb;
+}
+
+//Fetches url from the real server and records it. Returns false if it couldn't be fetched at all.
+bool record(const std::string& url, Recording* recorded, std::string* body) {
+	CURL* curl = curl_easy_init();
+	if (!curl) return false;
+	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, appendBody);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, body);
+	CURLcode result = curl_easy_perform(curl);
+	char* contentType = nullptr;
+	if (result == CURLE_OK) {
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &recorded->status);
+		curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &contentType);
+	}
+	recorded->contentType = contentType ? contentType : "application/octet-stream";
+	curl_easy_cleanup(curl);
+	if (result != CURLE_OK) {
+		std::cout << "Can't record " << url << ": " << curl_easy_strerror(result) << std::endl;
+		return false;
+	}
+	recorded->file = hashHex(url) + ".body";
+	std::ofstream(directory + "/" + recorded->file, std::ios::binary).write(body->data(), body->size());
+	std::lock_guard<std::mutex> guard(stateLock);
+	recordings[url] = *recorded;
+	std::ofstream(directory + "/index.tsv", std::ios::app) << recorded->file << '\t' << recorded->status << '\t'
+		<< recorded->contentType << '\t' << url << '\n';
+	return true;
+}
+
+//Sends data at the faults' bandwidth, stalling or cutting it off halfway if asked. False if the connection went.
+bool sendPaced(Socket client, const std::string& data, int bandwidthKbps, int stallMs, bool reset) {
+	//20 slices a second when capped
+	size_t slice = bandwidthKbps > 0 ? std::max<size_t>(1, (size_t)bandwidthKbps * 1000 / 8 / 20) : 64 * 1024;
+	size_t half = data.size() / 2;
+	bool stalled = false;
+	size_t sent = 0;
+	while (sent < data.size()) {
+		if (sent >= half && !stalled) {
+			if (reset) return false;
+			if (stallMs > 0) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(stallMs));
+			}
+			stalled = true;
+		}
+		size_t end = std::min(data.size(), sent + slice);
+		//the stall and reset land halfway exactly
+		if (sent < half && end > half) end = half;
+		while (sent < end) {
+			int n = send(client, data.data() + sent, (int)(end - sent), 0);
+			if (n <= 0) return false;
+			sent += n;
+		}
+		if (bandwidthKbps > 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+	}
+	return true;
+}
+
+void serve(Socket client) {
+	auto start = std::chrono::steady_clock::now();
+	std::string request = readRequest(client);
+	std::string path = requestPath(request);
+	//"/https/host/path" -> "https://host/path"
+	size_t schemeEnd = path.find('/', 1);
+	std::string url = schemeEnd == std::string::npos ? "" : path.substr(1, schemeEnd - 1) + "://" + path.substr(schemeEnd + 1);
+
+	Recording recorded;
+	std::string body;
+	bool found = false;
+	{
+		std::lock_guard<std::mutex> guard(stateLock);
+		auto existing = recordings.find(url);
+		if (existing != recordings.end()) {
+			recorded = existing->second;
+			found = true;
+		}
+	}
+	if (found) {
+		found = readFile(directory + "/" + recorded.file, &body);
+	}
+	else if (recording && !url.empty()) {
+		found = record(url, &recorded, &body);
+	}
+
+	//the dice are this request's own, seeded by the url and its turn, so a seed gives the same faults whatever
+	//order concurrent requests arrive in
+	bool faulty = faults.match.empty() || url.find(faults.match) != std::string::npos;
+	int waitMs = 0;
+	bool error = false, stall = false, reset = false;
+	if (faulty) {
+		uint64_t turn;
+		{
+			std::lock_guard<std::mutex> guard(stateLock);
+			turn = requestCounts[url]++;
+		}
+		std::mt19937_64 dice(hash64(std::to_string(seed) + " " + url + " " + std::to_string(turn)));
+		std::uniform_real_distribution<double> chance(0, 1);
+		waitMs = faults.latencyMs + (faults.jitterMs > 0 ? (int)(dice() % (faults.jitterMs + 1)) : 0);
+		error = chance(dice) < faults.errorRate;
+		stall = chance(dice) < faults.stallRate;
+		reset = chance(dice) < faults.resetRate;
+	}
+	if (waitMs > 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(waitMs));
+	}
+
+	std::string response;
+	const char* outcome = "";
+	if (error) {
+		response = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+		outcome = " (injected error)";
+	}
+	else if (!found) {
+		response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+		outcome = " (not recorded)";
+	}
+	else {
+		std::string etag = "\"" + hashHex(body) + "\"";
+		if (recorded.status == 200 && header(request, "if-none-match") == etag) {
+			response = "HTTP/1.1 304 Not Modified\r\nETag: " + etag + "\r\nConnection: close\r\n\r\n";
+			body.clear();
+		}
+		else {
+			response = "HTTP/1.1 " + std::to_string(recorded.status) + " Recorded\r\nContent-Type: " + recorded.contentType +
+				"\r\nETag: " + etag + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+		}
+		if (stall) outcome = " (stalled)";
+		if (reset) outcome = " (reset)";
+	}
+	bool whole = sendPaced(client, response + body, faulty ? faults.bandwidthKbps : 0, stall ? faults.stallMs : 0, reset && found && !error);
+	closesocket(client);
+
+	long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	std::lock_guard<std::mutex> guard(stateLock);
+	std::cout << response.substr(9, 3) << " " << body.size() << " bytes " << ms << " ms " << (whole ? "" : "cut ") << url << outcome << std::endl;
+}
+
+bool parseOptions(int argc, char* argv[], int* port) {
+	int i = 1;
+	if (argc > 1 && argv[1][0] != '-') {
+		*port = atoi(argv[1]);
+		i = 2;
+	}
+	for (; i < argc; i++) {
+		std::string option = argv[i];
+		if (option == "--record" || option == "--replay") {
+			recording = option == "--record";
+			if (i + 1 < argc && argv[i + 1][0] != '-') {
+				directory = argv[++i];
+			}
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cout << option << " needs a value" << std::endl;
+			return false;
+		}
+		std::string value = argv[++i];
+		if (option == "--latency") faults.latencyMs = atoi(value.c_str());
+		else if (option == "--jitter") faults.jitterMs = atoi(value.c_str());
+		else if (option == "--bandwidth") faults.bandwidthKbps = atoi(value.c_str());
+		else if (option == "--stall-rate") faults.stallRate = atof(value.c_str());
+		else if (option == "--stall-ms") faults.stallMs = atoi(value.c_str());
+		else if (option == "--error-rate") faults.errorRate = atof(value.c_str());
+		else if (option == "--reset-rate") faults.resetRate = atof(value.c_str());
+		else if (option == "--match") faults.match = value;
+		else if (option == "--seed") seed = (unsigned)atoi(value.c_str());
+		else if (option == "--profile" && value == "3g") {
+			faults.latencyMs = 300;
+			faults.jitterMs = 200;
+			faults.bandwidthKbps = 750;
+		}
+		else if (option == "--profile" && value == "flaky-cdn") {
+			faults.match = "img.mlbstatic.com";
+			faults.latencyMs = 50;
+			faults.jitterMs = 400;
+			faults.stallRate = 0.1;
+			faults.stallMs = 5000;
+			faults.errorRate = 0.05;
+			faults.resetRate = 0.03;
+		}
+		else {
+			std::cout << "Unknown option " << option << " " << value << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	int port = 8090;
+	if (!parseOptions(argc, argv, &port)) return 1;
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	loadIndex();
+	Socket listener = listenLocal(port, 64);
+	if (listener == INVALID_SOCKET) return 1;
+	std::cout << (recording ? "Recording" : "Replaying") << " on http://localhost:" << port << ", run GameBar with --origin http://localhost:" << port << std::endl;
+	acceptForever(listener, serve);
+}
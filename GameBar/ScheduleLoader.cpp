@@ -0,0 +1,217 @@
+#include "ScheduleLoader.h"
+#include "Constants.h"
+#include "DateIndex.h"
+#include "Download.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <tuple>
+
+static int64_t microsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void FeedStats::print(const char* what, int feed) {
+	std::cout << what;
+	if (feed >= 0) {
+		std::cout << " sportId=" << FEED_SPORT_IDS[feed];
+	}
+	std::cout << ": " << fetches << " fetches, " << failures << " failed, " << bytes << " bytes";
+	if (fetches > 0) {
+		std::cout << ", " << fetchMicros / fetches / 1000 << " ms fetch, " << parseMicros / fetches / 1000.0 << " ms parse average";
+	}
+	std::cout << std::endl;
+}
+
+std::string feedUrl(const std::string& base, int feed, int day) {
+	return base + formatDay(day) + "&sportId=" + std::to_string(FEED_SPORT_IDS[feed]);
+}
+
+bool scanBatch(ScheduleBatch* batch) {
+	if (!extractSchedule(batch->response, &batch->records)) {
+		return false;
+	}
+	if (batch->refresh) {
+		batch->fingerprints.clear();
+		for (const GameRecord& game : batch->records.games) {
+			batch->fingerprints.push_back(gameFingerprint(game));
+		}
+	}
+	return true;
+}
+
+void mergeFeeds(const std::vector<const ScheduleRecords*>& feeds, ScheduleRecords* out) {
+	out->dates.clear();
+	out->games.clear();
+	out->cuts.clear();
+	//each feed's games in start order, and where each feed's cuts land in out
+	std::vector<std::vector<std::pair<int64_t, int>>> sorted(feeds.size());
+	std::vector<int> cutOffsets(feeds.size());
+	size_t total = 0;
+	for (size_t f = 0; f < feeds.size(); f++) {
+		const std::vector<GameRecord>& games = feeds[f]->games;
+		for (int i = 0; i < (int)games.size(); i++) {
+			sorted[f].emplace_back(gameStartTime(games[i]), i);
+		}
+		//pairs compare on the index second, so equal start times keep the feed's own order
+		if (!std::is_sorted(sorted[f].begin(), sorted[f].end())) {
+			std::sort(sorted[f].begin(), sorted[f].end());
+		}
+		cutOffsets[f] = (int)out->cuts.size();
+		out->cuts.insert(out->cuts.end(), feeds[f]->cuts.begin(), feeds[f]->cuts.end());
+		total += games.size();
+	}
+
+	//heap of each feed's next game: (start, feed, position in sorted[feed]), earliest start then lowest feed on top
+	typedef std::tuple<int64_t, int, int> Head;
+	std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+	for (int f = 0; f < (int)feeds.size(); f++) {
+		if (!sorted[f].empty()) {
+			heads.emplace(sorted[f][0].first, f, 0);
+		}
+	}
+	out->games.reserve(total);
+	while (!heads.empty()) {
+		int f = std::get<1>(heads.top());
+		int position = std::get<2>(heads.top());
+		heads.pop();
+		GameRecord game = feeds[f]->games[sorted[f][position].second];
+		game.firstCut += cutOffsets[f];
+		out->games.push_back(game);
+		if (position + 1 < (int)sorted[f].size()) {
+			heads.emplace(sorted[f][position + 1].first, f, position + 1);
+		}
+	}
+
+	out->totalGames = (int)out->games.size();
+	for (const ScheduleRecords* feed : feeds) {
+		if (!feed->dates.empty()) {
+			DateRecord date;
+			date.date = feed->dates[0].date;
+			date.gameCount = out->totalGames;
+			out->dates.push_back(date);
+			break;
+		}
+	}
+}
+
+ScheduleLoader::ScheduleLoader(JobSystem* jobSystem) {
+	jobs = jobSystem;
+	pendingEditorial = 0;
+	merges = 0;
+	mergeMicros = 0;
+}
+
+void ScheduleLoader::requestDay(int day, bool reconcile) {
+	auto merged = std::make_shared<ScheduleBatch>();
+	merged->day = day;
+	merged->refresh = reconcile;
+	std::vector<JobRef> fetches;
+	for (int feed = 0; feed < FEED_COUNT; feed++) {
+		auto part = std::make_shared<ScheduleBatch>();
+		part->day = day;
+		part->feed = feed;
+		merged->parts.push_back(part);
+		//a reconcile needs editorial content too, or the headlines it already has would look changed
+		std::string url = feedUrl(reconcile ? refreshUrl : scheduleUrl, feed, day);
+		fetches.push_back(jobs->run(JOB_PRIORITY_NORMAL, [this, part, url]() {
+			download(part.get(), url, &feedStats[part->feed]);
+		}));
+	}
+	//once every feed is in; a failed feed contributes no games
+	jobs->run(JOB_PRIORITY_NORMAL, [this, merged]() {
+		auto start = std::chrono::steady_clock::now();
+		std::vector<const ScheduleRecords*> feeds;
+		for (const auto& part : merged->parts) {
+			if (part->ok) {
+				feeds.push_back(&part->records);
+			}
+		}
+		merged->ok = !feeds.empty();
+		mergeFeeds(feeds, &merged->records);
+		if (merged->refresh) {
+			for (const GameRecord& game : merged->records.games) {
+				merged->fingerprints.push_back(gameFingerprint(game));
+			}
+		}
+		merges++;
+		mergeMicros += microsSince(start);
+		finished.push(merged);
+	}, fetches);
+}
+
+void ScheduleLoader::requestEditorial(std::vector<int> gamePks) {
+	if (gamePks.empty()) return;
+	std::string url = editorialUrl;
+	for (size_t i = 0; i < gamePks.size(); i++) {
+		if (i > 0) url += ",";
+		url += std::to_string(gamePks[i]);
+	}
+	url += "&sportId=";
+	for (int feed = 0; feed < FEED_COUNT; feed++) {
+		if (feed > 0) url += ",";
+		url += std::to_string(FEED_SPORT_IDS[feed]);
+	}
+	auto batch = std::make_shared<ScheduleBatch>();
+	batch->gamePks = std::move(gamePks);
+	pendingEditorial++;
+	jobs->run(JOB_PRIORITY_NORMAL, [this, batch, url]() {
+		download(batch.get(), url, &editorialStats);
+		finished.push(batch);
+	});
+}
+
+void ScheduleLoader::download(ScheduleBatch* batch, const std::string& url, FeedStats* stats) {
+	auto start = std::chrono::steady_clock::now();
+	stats->fetches++;
+	if (!downloadString(url, &batch->response)) {
+		stats->failures++;
+		stats->fetchMicros += microsSince(start);
+		return;
+	}
+	stats->fetchMicros += microsSince(start);
+	stats->bytes += batch->response.size();
+	start = std::chrono::steady_clock::now();
+	batch->ok = scanBatch(batch);
+	stats->parseMicros += microsSince(start);
+	if (!batch->ok) {
+		stats->failures++;
+		std::cout << "Schedule json parse error: " << url << std::endl;
+	}
+}
+
+bool ScheduleLoader::poll(std::shared_ptr<ScheduleBatch>* batch) {
+	if (!finished.pop(batch)) {
+		return false;
+	}
+	if ((*batch)->day < 0) {
+		pendingEditorial--;
+	}
+	return true;
+}
+
+int ScheduleLoader::getPendingEditorial() {
+	return pendingEditorial;
+}
+
+size_t ScheduleLoader::getBytes() {
+	size_t bytes = editorialStats.bytes;
+	for (int feed = 0; feed < FEED_COUNT; feed++) {
+		bytes += feedStats[feed].bytes;
+	}
+	return bytes;
+}
+
+void ScheduleLoader::printStats() {
+	for (int feed = 0; feed < FEED_COUNT; feed++) {
+		feedStats[feed].print("Schedule feed", feed);
+	}
+	editorialStats.print("Editorial", -1);
+	std::cout << "Schedule merges: " << merges;
+	if (merges > 0) {
+		std::cout << ", " << mergeMicros / merges << " us average";
+	}
+	std::cout << std::endl;
+}
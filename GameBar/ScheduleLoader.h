@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Constants.h"
+#include "JobSystem.h"
+#include "LockFreeQueue.h"
+#include "ScheduleParser.h"
+
+//One finished schedule fetch: a day's bare schedule, a batch of editorial content, or live updates from an
+//UpdateSource. records point into response, so the two travel together.
+struct ScheduleBatch {
+	//the day fetched (see DateIndex.h), -1 for an editorial batch
+	int day = -1;
+	//the feed fetched (index into FEED_SPORT_IDS), -1 for a batch covering every feed
+	int feed = -1;
+	//a day's batch merged from its feeds' batches, which hold the responses records point into
+	std::vector<std::shared_ptr<ScheduleBatch>> parts;
+	//live updates: current records of games that may have changed, for GameStore::patchGame()
+	bool refresh = false;
+	//refresh only: gameFingerprint() of each record, worked out off the UI thread
+	std::vector<uint64_t> fingerprints;
+	//refresh only: SDL_GetPerformanceCounter() when the last byte arrived, 0 if unknown
+	Uint64 receivedAt = 0;
+	//the games an editorial batch asked for
+	std::vector<int> gamePks;
+	std::string response;
+	ScheduleRecords records;
+	bool ok = false;
+};
+
+//Fetch metrics of one feed, updated from jobs.
+struct FeedStats {
+	std::atomic<int> fetches{ 0 };
+	std::atomic<int> failures{ 0 };
+	std::atomic<size_t> bytes{ 0 };
+	std::atomic<int64_t> fetchMicros{ 0 };
+	std::atomic<int64_t> parseMicros{ 0 };
+
+	//Prints one line to stdout, labelled with what and the feed's sportId (none if feed is -1).
+	void print(const char* what, int feed);
+};
+
+//base + YYYY-MM-DD + "&sportId=" + feed's sportId.
+std::string feedUrl(const std::string& base, int feed, int day);
+
+//Scans batch->response into records, fingerprinting the games of a refresh. Returns false if it didn't parse.
+bool scanBatch(ScheduleBatch* batch);
+
+//Merges one day's games from several feeds into out, ordered by gameStartTime(). Each feed's games are sorted
+//first (statsapi mostly has them in order already), then the feeds are k-way merged; ties keep feed order.
+//out gets a single date and every feed's cuts, with the games' cut ranges moved to match. Its views point
+//into the feeds' responses.
+void mergeFeeds(const std::vector<const ScheduleRecords*>& feeds, ScheduleRecords* out);
+
+//Fetches schedule responses in the background: the bare schedule for a day as the carousel pages toward
+//it, and headlines and image cuts for batches of games once they're near the screen. A day is one statsapi
+//call per feed, fetched and scanned concurrently by jobs, then merged by a job that waits on them all; an
+//editorial batch is one call covering every feed. The UI thread requests and polls; merging into the
+//store is up to it.
+class ScheduleLoader
+{
+public:
+	//Fetches run as jobs on jobSystem, which must be stopped before the loader is destroyed.
+	ScheduleLoader(JobSystem* jobSystem);
+
+	//UI thread. Queues a fetch of day's bare schedule from every feed. The day's batch is ok if any feed was.
+	//With reconcile set the day is fetched with editorial content and comes back as a refresh, to patch a day
+	//that is already loaded.
+	void requestDay(int day, bool reconcile = false);
+
+	//UI thread. Queues a fetch of editorial content for gamePks.
+	void requestEditorial(std::vector<int> gamePks);
+
+	//UI thread. Takes the next finished batch of either kind, returns false if there is none.
+	bool poll(std::shared_ptr<ScheduleBatch>* batch);
+
+	//editorial batches requested and not yet polled
+	int getPendingEditorial();
+	//response bytes fetched so far, days and editorial
+	size_t getBytes();
+	//Prints each feed's fetches, then editorial's and the merges'.
+	void printStats();
+
+private:
+	//Runs on a job: fetches url into batch and scans it.
+	void download(ScheduleBatch* batch, const std::string& url, FeedStats* stats);
+
+	JobSystem* jobs;
+	MpscQueue<std::shared_ptr<ScheduleBatch>> finished;
+	int pendingEditorial;
+	FeedStats feedStats[FEED_COUNT];
+	FeedStats editorialStats;
+	std::atomic<int> merges;
+	std::atomic<int64_t> mergeMicros;
+};
@@ -0,0 +1,366 @@
+#include "ScheduleParser.h"
+#include <cstdint>
+
+//Forward-only scanner over a JSON buffer. Nothing is copied; strings come back as views of their raw contents.
+class JsonScanner
+{
+public:
+	JsonScanner(std::string_view json) {
+		p = json.data();
+		end = json.data() + json.size();
+	}
+
+	void skipWhitespace() {
+		while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) p++;
+	}
+
+	bool peek(char c) {
+		skipWhitespace();
+		return p < end && *p == c;
+	}
+
+	bool consume(char c) {
+		if (!peek(c)) return false;
+		p++;
+		return true;
+	}
+
+	bool string(std::string_view* out) {
+		if (!consume('"')) return false;
+		const char* start = p;
+		while (p < end && *p != '"') {
+			//skip the escaped character so \" doesn't end the string
+			if (*p == '\\') p++;
+			p++;
+		}
+		if (p >= end) return false;
+		*out = std::string_view(start, p - start);
+		p++;
+		return true;
+	}
+
+	//Reads the integer part of a number, discarding any fraction or exponent.
+	bool number(int* out) {
+		skipWhitespace();
+		bool negative = false;
+		if (p < end && *p == '-') {
+			negative = true;
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9') return false;
+		int64_t value = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			value = value * 10 + (*p - '0');
+			p++;
+		}
+		while (p < end && (*p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-' || (*p >= '0' && *p <= '9'))) p++;
+		*out = (int)(negative ? -value : value);
+		return true;
+	}
+
+	bool skipValue() {
+		skipWhitespace();
+		if (p >= end) return false;
+		if (*p == '"') {
+			std::string_view ignored;
+			return string(&ignored);
+		}
+		if (*p != '{' && *p != '[') {
+			//number, true, false or null
+			const char* start = p;
+			while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') p++;
+			return p > start;
+		}
+		//containers: track depth, stepping over strings so brackets inside them don't count
+		int depth = 0;
+		while (p < end) {
+			char c = *p;
+			if (c == '"') {
+				std::string_view ignored;
+				if (!string(&ignored)) return false;
+				continue;
+			}
+			p++;
+			if (c == '{' || c == '[') {
+				depth++;
+			}
+			else if (c == '}' || c == ']') {
+				if (--depth == 0) return true;
+			}
+		}
+		return false;
+	}
+
+	//Reads a string if one is next, otherwise skips whatever value is there and leaves out untouched.
+	bool optString(std::string_view* out) {
+		if (peek('"')) return string(out);
+		return skipValue();
+	}
+
+	//Reads a number if one is next, otherwise skips whatever value is there and leaves present false.
+	bool optNumber(int* out, bool* present) {
+		skipWhitespace();
+		if (p < end && (*p == '-' || (*p >= '0' && *p <= '9'))) {
+			*present = true;
+			return number(out);
+		}
+		return skipValue();
+	}
+
+	//Calls onMember(key) for each member of an object; onMember must consume the value. Non-objects are skipped.
+	template <typename F>
+	bool object(F onMember) {
+		if (!peek('{')) return skipValue();
+		p++;
+		if (consume('}')) return true;
+		do {
+			std::string_view key;
+			if (!string(&key) || !consume(':')) return false;
+			if (!onMember(key)) return false;
+		} while (consume(','));
+		return consume('}');
+	}
+
+	//Calls onElement() for each element of an array; onElement must consume the element. Non-arrays are skipped.
+	template <typename F>
+	bool array(F onElement) {
+		if (!peek('[')) return skipValue();
+		p++;
+		if (consume(']')) return true;
+		do {
+			if (!onElement()) return false;
+		} while (consume(','));
+		return consume(']');
+	}
+
+private:
+	const char* p;
+	const char* end;
+};
+
+static bool extractTeam(JsonScanner& scan, std::string_view* name, int* score, bool* hasScore) {
+	return scan.object([&](std::string_view key) {
+		if (key == "score") return scan.optNumber(score, hasScore);
+		if (key == "team") {
+			return scan.object([&](std::string_view teamKey) {
+				if (teamKey == "name") return scan.optString(name);
+				return scan.skipValue();
+			});
+		}
+		return scan.skipValue();
+	});
+}
+
+static bool extractCuts(JsonScanner& scan, std::vector<CutRecord>* cuts) {
+	return scan.array([&]() {
+		CutRecord cut;
+		bool hasWidth = false, hasHeight = false;
+		bool ok = scan.object([&](std::string_view key) {
+			if (key == "width") return scan.optNumber(&cut.width, &hasWidth);
+			if (key == "height") return scan.optNumber(&cut.height, &hasHeight);
+			if (key == "src") return scan.optString(&cut.src);
+			return scan.skipValue();
+		});
+		if (ok && hasWidth && hasHeight && isPresent(cut.src)) {
+			cuts->push_back(cut);
+		}
+		return ok;
+	});
+}
+
+//content.editorial.recap.mlb -> headline, media.image.cuts
+static bool extractRecap(JsonScanner& scan, GameRecord* game, std::vector<CutRecord>* cuts) {
+	return scan.object([&](std::string_view key) {
+		if (key == "headline") return scan.optString(&game->headline);
+		if (key == "media") {
+			return scan.object([&](std::string_view mediaKey) {
+				if (mediaKey != "image") return scan.skipValue();
+				return scan.object([&](std::string_view imageKey) {
+					if (imageKey != "cuts") return scan.skipValue();
+					game->firstCut = (int)cuts->size();
+					bool ok = extractCuts(scan, cuts);
+					game->cutCount = (int)cuts->size() - game->firstCut;
+					return ok;
+				});
+			});
+		}
+		return scan.skipValue();
+	});
+}
+
+static bool extractContent(JsonScanner& scan, GameRecord* game, std::vector<CutRecord>* cuts) {
+	return scan.object([&](std::string_view key) {
+		if (key != "editorial") return scan.skipValue();
+		return scan.object([&](std::string_view editorialKey) {
+			if (editorialKey != "recap") return scan.skipValue();
+			return scan.object([&](std::string_view recapKey) {
+				if (recapKey != "mlb") return scan.skipValue();
+				return extractRecap(scan, game, cuts);
+			});
+		});
+	});
+}
+
+static bool extractGame(JsonScanner& scan, ScheduleRecords* out) {
+	GameRecord game;
+	game.firstCut = (int)out->cuts.size();
+	bool hasPk = false;
+	bool ok = scan.object([&](std::string_view key) {
+		if (key == "gamePk") return scan.optNumber(&game.gamePk, &hasPk);
+		if (key == "officialDate") return scan.optString(&game.officialDate);
+		if (key == "gameDate") return scan.optString(&game.gameDate);
+		if (key == "doubleHeader") return scan.optString(&game.doubleHeader);
+		if (key == "gameNumber") return scan.optNumber(&game.gameNumber, &game.hasGameNumber);
+		if (key == "teams") {
+			return scan.object([&](std::string_view side) {
+				if (side == "away") return extractTeam(scan, &game.awayName, &game.awayScore, &game.hasAwayScore);
+				if (side == "home") return extractTeam(scan, &game.homeName, &game.homeScore, &game.hasHomeScore);
+				return scan.skipValue();
+			});
+		}
+		if (key == "content") return extractContent(scan, &game, &out->cuts);
+		return scan.skipValue();
+	});
+	if (ok) {
+		out->games.push_back(game);
+	}
+	return ok;
+}
+
+bool extractSchedule(std::string_view json, ScheduleRecords* out) {
+	JsonScanner scan(json);
+	bool hasTotal = false;
+	return scan.object([&](std::string_view key) {
+		if (key == "totalGames") return scan.optNumber(&out->totalGames, &hasTotal);
+		if (key != "dates") return scan.skipValue();
+		return scan.array([&]() {
+			DateRecord date;
+			date.firstGame = (int)out->games.size();
+			bool ok = scan.object([&](std::string_view dateKey) {
+				if (dateKey == "date") return scan.optString(&date.date);
+				if (dateKey == "games") {
+					return scan.array([&]() {
+						return extractGame(scan, out);
+					});
+				}
+				return scan.skipValue();
+			});
+			date.gameCount = (int)out->games.size() - date.firstGame;
+			out->dates.push_back(date);
+			return ok;
+		});
+	});
+}
+
+static void appendUtf8(std::string* out, uint32_t cp) {
+	if (cp < 0x80) {
+		out->push_back((char)cp);
+	}
+	else if (cp < 0x800) {
+		out->push_back((char)(0xC0 | (cp >> 6)));
+		out->push_back((char)(0x80 | (cp & 0x3F)));
+	}
+	else if (cp < 0x10000) {
+		out->push_back((char)(0xE0 | (cp >> 12)));
+		out->push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+		out->push_back((char)(0x80 | (cp & 0x3F)));
+	}
+	else {
+		out->push_back((char)(0xF0 | (cp >> 18)));
+		out->push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+		out->push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+		out->push_back((char)(0x80 | (cp & 0x3F)));
+	}
+}
+
+static bool readHex4(std::string_view raw, size_t i, uint32_t* out) {
+	if (i + 4 > raw.size()) return false;
+	uint32_t value = 0;
+	for (size_t j = i; j < i + 4; j++) {
+		char c = raw[j];
+		value <<= 4;
+		if (c >= '0' && c <= '9') value |= c - '0';
+		else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+		else return false;
+	}
+	*out = value;
+	return true;
+}
+
+std::string jsonUnescape(std::string_view raw) {
+	//most strings have no escapes at all
+	if (raw.find('\\') == std::string_view::npos) {
+		return std::string(raw);
+	}
+	std::string out;
+	out.reserve(raw.size());
+	for (size_t i = 0; i < raw.size(); i++) {
+		if (raw[i] != '\\' || i + 1 >= raw.size()) {
+			out.push_back(raw[i]);
+			continue;
+		}
+		char c = raw[++i];
+		switch (c) {
+		case 'b': out.push_back('\b'); break;
+		case 'f': out.push_back('\f'); break;
+		case 'n': out.push_back('\n'); break;
+		case 'r': out.push_back('\r'); break;
+		case 't': out.push_back('\t'); break;
+		case 'u': {
+			uint32_t cp;
+			if (!readHex4(raw, i + 1, &cp)) break;
+			i += 4;
+			//surrogate pair
+			uint32_t low;
+			if (cp >= 0xD800 && cp <= 0xDBFF && i + 2 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u' &&
+				readHex4(raw, i + 3, &low) && low >= 0xDC00 && low <= 0xDFFF) {
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+				i += 6;
+			}
+			appendUtf8(&out, cp);
+			break;
+		}
+		default:
+			//\" \\ \/
+			out.push_back(c);
+			break;
+		}
+	}
+	return out;
+}
+
+//FNV-1a
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t hashField(uint64_t hash, std::string_view field) {
+	//a missing field hashes differently from an empty one
+	uint64_t present = isPresent(field) ? field.size() + 1 : 0;
+	hash = hashBytes(hash, (const char*)&present, sizeof(present));
+	return hashBytes(hash, field.data(), field.size());
+}
+
+static uint64_t hashInt(uint64_t hash, int value, bool present) {
+	int64_t packed = present ? (int64_t)value : INT64_MIN;
+	return hashBytes(hash, (const char*)&packed, sizeof(packed));
+}
+
+uint64_t gameFingerprint(const GameRecord& game) {
+	uint64_t hash = 14695981039346656037ull;
+	hash = hashField(hash, game.officialDate);
+	hash = hashField(hash, game.gameDate);
+	hash = hashField(hash, game.doubleHeader);
+	hash = hashField(hash, game.awayName);
+	hash = hashField(hash, game.homeName);
+	hash = hashField(hash, game.headline);
+	hash = hashInt(hash, game.gameNumber, game.hasGameNumber);
+	hash = hashInt(hash, game.awayScore, game.hasAwayScore);
+	hash = hashInt(hash, game.homeScore, game.hasHomeScore);
+	return hash;
+}
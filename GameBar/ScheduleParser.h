@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//All string_views below point into the buffer handed to extractSchedule() and hold the raw JSON string
+//contents, escapes included. A view with a null data() was missing from the response. Use jsonUnescape()
+//when the text is actually needed.
+
+//One entry of a recap's image "cuts" array.
+struct CutRecord {
+	int width = 0;
+	int height = 0;
+	std::string_view src;
+};
+
+//The fields of a schedule "Game" object that GameStore uses.
+struct GameRecord {
+	int gamePk = 0;
+	std::string_view officialDate;
+	//start, "2018-06-10T17:05:00Z"
+	std::string_view gameDate;
+	std::string_view doubleHeader;
+	std::string_view awayName;
+	std::string_view homeName;
+	std::string_view headline;
+	int gameNumber = 0;
+	int awayScore = 0;
+	int homeScore = 0;
+	bool hasGameNumber = false;
+	bool hasAwayScore = false;
+	bool hasHomeScore = false;
+	//range in ScheduleRecords::cuts
+	int firstCut = 0;
+	int cutCount = 0;
+};
+
+//One entry of the schedule's "dates" array.
+struct DateRecord {
+	std::string_view date;
+	//range in ScheduleRecords::games
+	int firstGame = 0;
+	int gameCount = 0;
+};
+
+struct ScheduleRecords {
+	int totalGames = 0;
+	std::vector<DateRecord> dates;
+	std::vector<GameRecord> games;
+	std::vector<CutRecord> cuts;
+};
+
+//Scans a statsapi schedule response once, pulling out only the fields GameStore needs. Everything else is
+//skipped without being materialized. Returns false on malformed JSON.
+bool extractSchedule(std::string_view json, ScheduleRecords* out);
+
+//Hash of every field that feeds a game's display text or position: names, dates, start time, doubleheader,
+//scores and headline. Image cuts are left out. Equal fingerprints mean a refresh has nothing to change.
+uint64_t gameFingerprint(const GameRecord& game);
+
+//Decodes JSON string escapes (including \u sequences, to UTF-8). Missing views decode to "".
+std::string jsonUnescape(std::string_view raw);
+
+inline bool isPresent(std::string_view field) {
+	return field.data() != nullptr;
+}
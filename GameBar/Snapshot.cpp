@@ -0,0 +1,267 @@
+#include "Snapshot.h"
+#include "Constants.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <vector>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//records are read in place, so their layout is the file format
+static_assert(sizeof(SnapshotHeader) == 40, "snapshot header layout");
+static_assert(sizeof(SnapshotDay) == 8, "snapshot day layout");
+static_assert(sizeof(SnapshotGame) == 48, "snapshot game layout");
+static_assert(sizeof(SnapshotCut) == 16, "snapshot cut layout");
+
+//FNV-1a over the feeds' sportIds
+static uint32_t feedsHash() {
+	uint32_t hash = 2166136261u;
+	for (int feed = 0; feed < FEED_COUNT; feed++) {
+		hash = (hash ^ (uint32_t)FEED_SPORT_IDS[feed]) * 16777619u;
+	}
+	return hash;
+}
+
+bool writeSnapshot(const std::string& path, GameStore* games, DateIndex* dates, int selectedDay) {
+	std::vector<SnapshotDay> days;
+	std::vector<SnapshotGame> records;
+	std::vector<SnapshotCut> cuts;
+	std::string strings;
+	auto addString = [&strings](std::string_view s) {
+		SnapshotString out;
+		out.offset = (uint32_t)strings.size();
+		out.length = (uint32_t)s.size();
+		strings.append(s.data(), s.size());
+		return out;
+	};
+	if (!dates->empty()) {
+		for (int day = dates->getFirstDay(); day <= dates->getLastDay(); day++) {
+			SnapshotDay record;
+			record.day = day;
+			record.gameCount = (uint32_t)dates->gameCountOf(day);
+			days.push_back(record);
+		}
+	}
+	records.reserve(games->size());
+	for (int i = 0; i < games->size(); i++) {
+		StoredGame game = games->getStoredGame(i);
+		SnapshotGame record;
+		record.gamePk = game.gamePk;
+		record.editorialState = (uint32_t)game.editorialState;
+		record.fingerprint = game.fingerprint;
+		record.startTime = game.startTime;
+		record.title = addString(game.title);
+		record.description = addString(game.description);
+		record.firstCut = (uint32_t)cuts.size();
+		record.cutCount = (uint32_t)games->getCutCount(i);
+		for (uint32_t c = 0; c < record.cutCount; c++) {
+			StoredCut cut = games->getStoredCut(i, c);
+			SnapshotCut out;
+			out.width = cut.width;
+			out.height = cut.height;
+			out.url = addString(cut.url);
+			cuts.push_back(out);
+		}
+		records.push_back(record);
+	}
+
+	SnapshotHeader header = {};
+	memcpy(header.magic, "GBSS", 4);
+	header.version = SNAPSHOT_VERSION;
+	header.feeds = feedsHash();
+	header.selectedDay = selectedDay;
+	header.savedAt = (int64_t)time(nullptr);
+	header.dayCount = (uint32_t)days.size();
+	header.gameCount = (uint32_t)records.size();
+	header.cutCount = (uint32_t)cuts.size();
+	header.stringBytes = (uint32_t)strings.size();
+
+	std::string partPath = path + ".part";
+	FILE* file = fopen(partPath.c_str(), "wb");
+	if (!file) {
+		std::cout << "Error opening file " << partPath << "!" << std::endl;
+		return false;
+	}
+	fwrite(&header, sizeof(header), 1, file);
+	fwrite(days.data(), sizeof(SnapshotDay), days.size(), file);
+	fwrite(records.data(), sizeof(SnapshotGame), records.size(), file);
+	fwrite(cuts.data(), sizeof(SnapshotCut), cuts.size(), file);
+	fwrite(strings.data(), 1, strings.size(), file);
+	bool written = !ferror(file);
+	written = fclose(file) == 0 && written;
+#ifdef _WIN32
+	written = written && MoveFileExA(partPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	written = written && rename(partPath.c_str(), path.c_str()) == 0;
+#endif
+	if (!written) {
+		std::cout << "Error writing snapshot " << path << std::endl;
+		remove(partPath.c_str());
+	}
+	return written;
+}
+
+Snapshot::Snapshot() {
+	data = nullptr;
+	size = 0;
+	header = nullptr;
+	days = nullptr;
+	games = nullptr;
+	cuts = nullptr;
+	strings = nullptr;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = nullptr;
+#else
+	file = -1;
+#endif
+}
+
+Snapshot::~Snapshot() {
+	close();
+}
+
+bool Snapshot::open(const std::string& path) {
+	close();
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER fileSize;
+	if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(SnapshotHeader)) {
+		close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	data = mapping ? (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+	file = ::open(path.c_str(), O_RDONLY);
+	struct stat info;
+	if (file < 0 || fstat(file, &info) != 0 || info.st_size < (off_t)sizeof(SnapshotHeader)) {
+		close();
+		return false;
+	}
+	size = (size_t)info.st_size;
+	void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	data = view == MAP_FAILED ? nullptr : (const char*)view;
+#endif
+	if (!data) {
+		std::cout << "Error mapping snapshot " << path << std::endl;
+		close();
+		return false;
+	}
+
+	//every count and offset is checked before anything is read through it
+	header = (const SnapshotHeader*)data;
+	uint64_t daysAt = sizeof(SnapshotHeader);
+	uint64_t gamesAt = daysAt + (uint64_t)header->dayCount * sizeof(SnapshotDay);
+	uint64_t cutsAt = gamesAt + (uint64_t)header->gameCount * sizeof(SnapshotGame);
+	uint64_t stringsAt = cutsAt + (uint64_t)header->cutCount * sizeof(SnapshotCut);
+	if (memcmp(header->magic, "GBSS", 4) != 0 || header->version != SNAPSHOT_VERSION || header->feeds != feedsHash() ||
+		stringsAt + header->stringBytes > size) {
+		close();
+		return false;
+	}
+	days = (const SnapshotDay*)(data + daysAt);
+	games = (const SnapshotGame*)(data + gamesAt);
+	cuts = (const SnapshotCut*)(data + cutsAt);
+	strings = data + stringsAt;
+
+	auto validString = [this](SnapshotString s) {
+		return (uint64_t)s.offset + s.length <= header->stringBytes;
+	};
+	bool valid = true;
+	uint64_t dayGames = 0;
+	for (uint32_t d = 0; d < header->dayCount; d++) {
+		//days are one contiguous run, like DateIndex's
+		valid = valid && days[d].day == days[0].day + (int32_t)d;
+		dayGames += days[d].gameCount;
+	}
+	valid = valid && dayGames == header->gameCount;
+	for (uint32_t g = 0; valid && g < header->gameCount; g++) {
+		const SnapshotGame& game = games[g];
+		valid = validString(game.title) && validString(game.description) && game.editorialState <= EDITORIAL_FAILED &&
+			(uint64_t)game.firstCut + game.cutCount <= header->cutCount;
+	}
+	for (uint32_t c = 0; valid && c < header->cutCount; c++) {
+		valid = validString(cuts[c].url);
+	}
+	if (!valid) {
+		std::cout << "Snapshot " << path << " is damaged, ignoring it" << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void Snapshot::close() {
+#ifdef _WIN32
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	mapping = nullptr;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (data) munmap((void*)data, size);
+	if (file >= 0) ::close(file);
+	file = -1;
+#endif
+	data = nullptr;
+	size = 0;
+	header = nullptr;
+}
+
+bool Snapshot::contains(int day) {
+	return header && header->dayCount > 0 && day >= days[0].day && day < days[0].day + (int)header->dayCount;
+}
+
+int Snapshot::getSelectedDay() {
+	return header ? header->selectedDay : -1;
+}
+
+int64_t Snapshot::getSavedAt() {
+	return header ? header->savedAt : 0;
+}
+
+int Snapshot::getGameCount() {
+	return header ? (int)header->gameCount : 0;
+}
+
+void Snapshot::loadInto(GameStore* store, DateIndex* dates) {
+	if (!header) return;
+	for (uint32_t d = 0; d < header->dayCount; d++) {
+		dates->append(days[d].day, (int)days[d].gameCount);
+	}
+	std::vector<StoredCut> gameCuts;
+	for (uint32_t g = 0; g < header->gameCount; g++) {
+		const SnapshotGame& record = games[g];
+		StoredGame game;
+		game.gamePk = record.gamePk;
+		game.title = string(record.title);
+		game.description = string(record.description);
+		game.editorialState = (EditorialState)record.editorialState;
+		game.fingerprint = record.fingerprint;
+		game.startTime = record.startTime;
+		gameCuts.clear();
+		for (uint32_t c = record.firstCut; c < record.firstCut + record.cutCount; c++) {
+			StoredCut cut;
+			cut.width = cuts[c].width;
+			cut.height = cuts[c].height;
+			cut.url = string(cuts[c].url);
+			gameCuts.push_back(cut);
+		}
+		store->addStoredGame(game, gameCuts.data(), (int)gameCuts.size());
+	}
+}
+
+std::string_view Snapshot::string(SnapshotString s) {
+	return std::string_view(strings + s.offset, s.length);
+}
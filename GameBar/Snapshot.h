@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "DateIndex.h"
+#include "GameStore.h"
+
+//Binary copy of the loaded days, written on exit so the next start can fill the carousel before any fetch
+//returns, or without a network at all. The file is mapped and read in place: a header, then fixed size day,
+//game and cut records, then the strings they refer to. Every record is 8-byte aligned, little-endian.
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotString {
+	uint32_t offset;
+	uint32_t length;
+};
+
+struct SnapshotHeader {
+	char magic[4];	//"GBSS"
+	uint32_t version;
+	//hash of FEED_SPORT_IDS, a snapshot of other feeds is ignored
+	uint32_t feeds;
+	//day the selection was on
+	int32_t selectedDay;
+	//seconds since 1970
+	int64_t savedAt;
+	uint32_t dayCount;
+	uint32_t gameCount;
+	uint32_t cutCount;
+	uint32_t stringBytes;
+};
+
+//A loaded day; its games follow the previous day's.
+struct SnapshotDay {
+	int32_t day;
+	uint32_t gameCount;
+};
+
+struct SnapshotGame {
+	int32_t gamePk;
+	uint32_t editorialState;
+	uint64_t fingerprint;
+	int64_t startTime;
+	SnapshotString title;
+	SnapshotString description;
+	uint32_t firstCut;
+	uint32_t cutCount;
+};
+
+struct SnapshotCut {
+	int32_t width;
+	int32_t height;
+	SnapshotString url;
+};
+
+//Writes every loaded day to path: to a temporary file first, renamed over the old snapshot once complete, so
+//a crash mid-write leaves the last good one. Returns false if it couldn't be written.
+bool writeSnapshot(const std::string& path, GameStore* games, DateIndex* dates, int selectedDay);
+
+//A snapshot mapped read-only. Nothing is copied until loadInto().
+class Snapshot
+{
+public:
+	Snapshot();
+	Snapshot(const Snapshot&) = delete;
+	Snapshot& operator=(const Snapshot&) = delete;
+	~Snapshot();
+
+	//Maps path and checks it through. Returns false if it is missing, truncated, inconsistent, or from another
+	//version or feed set.
+	bool open(const std::string& path);
+	//Unmaps the file.
+	void close();
+
+	bool contains(int day);
+	int getSelectedDay();
+	int64_t getSavedAt();
+	int getGameCount();
+
+	//Appends every stored day to games and dates, which must both be empty.
+	void loadInto(GameStore* games, DateIndex* dates);
+
+private:
+	std::string_view string(SnapshotString s);
+
+	const char* data;
+	size_t size;
+	const SnapshotHeader* header;
+	const SnapshotDay* days;
+	const SnapshotGame* games;
+	const SnapshotCut* cuts;
+	const char* strings;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int file;
+#endif
+};
@@ -0,0 +1,282 @@
+#include "StreamUpdateSource.h"
+#include "Constants.h"
+#include "DateIndex.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <list>
+#include <curlpp/cURLpp.hpp>
+#include <curlpp/Easy.hpp>
+#include <curlpp/Options.hpp>
+#include <curlpp/Infos.hpp>
+
+EventStreamParser::EventStreamParser(EventHandler handler) {
+	onEvent = handler;
+	afterCR = false;
+	retryMs = 0;
+}
+
+void EventStreamParser::feed(const char* bytes, size_t length) {
+	for (size_t i = 0; i < length; i++) {
+		char c = bytes[i];
+		//the \n of a \r\n pair
+		if (afterCR && c == '\n') {
+			afterCR = false;
+			continue;
+		}
+		afterCR = c == '\r';
+		if (c == '\r' || c == '\n') {
+			processLine(line);
+			line.clear();
+		}
+		else {
+			line.push_back(c);
+		}
+	}
+}
+
+void EventStreamParser::reset() {
+	line.clear();
+	type.clear();
+	data.clear();
+	afterCR = false;
+}
+
+Uint32 EventStreamParser::getRetryMs() {
+	return retryMs;
+}
+
+void EventStreamParser::processLine(const std::string& text) {
+	//a blank line ends the event
+	if (text.empty()) {
+		if (!data.empty()) {
+			data.pop_back();
+			onEvent(type.empty() ? "message" : type, data, id);
+		}
+		type.clear();
+		data.clear();
+		return;
+	}
+	//comment, usually a keepalive
+	if (text[0] == ':') return;
+
+	size_t colon = text.find(':');
+	std::string field = text.substr(0, colon);
+	std::string value;
+	if (colon != std::string::npos) {
+		value = text.substr(text.size() > colon + 1 && text[colon + 1] == ' ' ? colon + 2 : colon + 1);
+	}
+	if (field == "event") {
+		type = value;
+	}
+	else if (field == "data") {
+		data += value;
+		data += '\n';
+	}
+	else if (field == "id") {
+		//the last id stays in effect for later events that don't set one
+		id = value;
+	}
+	else if (field == "retry" && !value.empty() && std::all_of(value.begin(), value.end(), ::isdigit)) {
+		retryMs = (Uint32)std::stoul(value);
+	}
+}
+
+StreamUpdateSource::StreamUpdateSource(std::string url)
+	: parser([this](const std::string& type, const std::string& data, const std::string& id) {
+		lastEventId = id;
+		if (type == "games" || type == "message") {
+			deliver(data);
+		}
+	}) {
+	baseUrl = url;
+	firstDay = lastDay = -1;
+	generation = 0;
+	eventsThisConnection = 0;
+	failures = 0;
+	stopping = false;
+	bytes = 0;
+	events = connections = 0;
+	wake = SDL_CreateSemaphore(0);
+	thread = std::thread(&StreamUpdateSource::run, this);
+}
+
+StreamUpdateSource::~StreamUpdateSource() {
+	stopping = true;
+	SDL_SemPost(wake);
+	thread.join();
+	SDL_DestroySemaphore(wake);
+}
+
+void StreamUpdateSource::watch(int first, int last) {
+	std::lock_guard<std::mutex> guard(daysLock);
+	if (first == firstDay && last == lastDay) return;
+	firstDay = first;
+	lastDay = last;
+	generation++;
+	SDL_SemPost(wake);
+}
+
+void StreamUpdateSource::update(Uint32) {
+	//the stream thread does the work
+}
+
+bool StreamUpdateSource::poll(std::shared_ptr<ScheduleBatch>* batch) {
+	return finished.pop(batch);
+}
+
+bool StreamUpdateSource::isHealthy() {
+	return failures < STREAM_FAILURES_BEFORE_POLLING;
+}
+
+const char* StreamUpdateSource::getName() {
+	return "stream";
+}
+
+void StreamUpdateSource::printStats() {
+	std::cout << "Update stream: " << connections << " connections, " << events << " events, " << bytes << " bytes" << std::endl;
+}
+
+void StreamUpdateSource::run() {
+	while (!stopping) {
+		int current = generation;
+		std::string url;
+		{
+			std::lock_guard<std::mutex> guard(daysLock);
+			if (firstDay >= 0) {
+				url = baseUrl + "from=" + formatDay(firstDay) + "&to=" + formatDay(lastDay);
+			}
+		}
+		if (url.empty()) {
+			//nothing to follow yet
+			SDL_SemWaitTimeout(wake, 1000);
+			continue;
+		}
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		ConnectResult result = connect(url, current);
+		httpSeconds[HTTP_STREAM].observeTicks(SDL_GetPerformanceCounter() - start);
+		if (stopping) break;
+		Uint32 wait = 0;
+		if (result == CONNECT_FAILED) {
+			failures++;
+			httpRetries[RETRY_STREAM].add();
+			int doublings = std::min(failures - 1, 5);
+			wait = std::min(STREAM_MAX_BACKOFF_MS, STREAM_BACKOFF_MS << doublings);
+		}
+		else if (result == CONNECT_ENDED) {
+			failures = 0;
+			//a closed stream or a long poll answer; if the server sends nothing at all, don't hammer it
+			if (eventsThisConnection == 0) {
+				wait = parser.getRetryMs() > 0 ? parser.getRetryMs() : STREAM_BACKOFF_MS;
+			}
+		}
+		//interrupted for new days: reconnect at once
+		if (wait > 0) {
+			SDL_SemWaitTimeout(wake, wait);
+		}
+	}
+}
+
+StreamUpdateSource::ConnectResult StreamUpdateSource::connect(const std::string& url, int current) {
+	connections++;
+	httpRequests[HTTP_STREAM].add();
+	eventsThisConnection = 0;
+	parser.reset();
+	bool streaming = false;
+	std::string body;
+	//a long poll answer's event id, from its Last-Event-ID header
+	std::string pollEventId;
+	auto interrupted = [this, current]() {
+		return stopping || generation != current;
+	};
+	try {
+		curlpp::Easy request;
+		request.setOpt(new curlpp::options::Url(url));
+		request.setOpt(new curlpp::options::FailOnError(true));
+		std::list<std::string> headers;
+		headers.push_back("Accept: text/event-stream");
+		headers.push_back("Cache-Control: no-cache");
+		if (!lastEventId.empty()) {
+			headers.push_back("Last-Event-ID: " + lastEventId);
+		}
+		request.setOpt(new curlpp::options::HttpHeader(headers));
+		request.setOpt(new curlpp::options::HeaderFunction([&streaming, &pollEventId](char* ptr, size_t size, size_t nmemb) {
+			std::string line(ptr, size * nmemb);
+			std::string lower = line;
+			std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+			if (lower.compare(0, 13, "content-type:") == 0 && lower.find("text/event-stream") != std::string::npos) {
+				streaming = true;
+			}
+			if (lower.compare(0, 14, "last-event-id:") == 0) {
+				size_t start = line.find_first_not_of(" \t", 14);
+				size_t end = line.find_last_not_of(" \t\r\n");
+				pollEventId = start != std::string::npos && end >= start ? line.substr(start, end - start + 1) : "";
+			}
+			return size * nmemb;
+		}));
+		request.setOpt(new curlpp::options::WriteFunction([&](char* ptr, size_t size, size_t nmemb) -> size_t {
+			//a short count aborts the transfer
+			if (interrupted()) return 0;
+			bytes += size * nmemb;
+			httpBytes[HTTP_STREAM].add(size * nmemb);
+			if (streaming) {
+				parser.feed(ptr, size * nmemb);
+			}
+			else {
+				body.append(ptr, size * nmemb);
+			}
+			return size * nmemb;
+		}));
+		//checked about once a second while the stream is idle
+		request.setOpt(new curlpp::options::NoProgress(false));
+		request.setOpt(new curlpp::options::ProgressFunction([&](double, double, double, double) {
+			return interrupted() ? 1 : 0;
+		}));
+		request.setOpt(new curlpp::options::ConnectTimeout(5));
+		//keepalives arrive well within this; a silent connection is dead
+		request.setOpt(new curlpp::options::LowSpeedLimit(1));
+		request.setOpt(new curlpp::options::LowSpeedTime(STREAM_IDLE_TIMEOUT_S));
+		request.perform();
+	}
+	catch (curlpp::LogicError& e) {
+		std::cout << e.what() << std::endl;
+		httpFailures[HTTP_STREAM].add();
+		return CONNECT_FAILED;
+	}
+	catch (curlpp::RuntimeError& e) {
+		if (interrupted()) {
+			httpCancelled[HTTP_STREAM].add();
+			return CONNECT_INTERRUPTED;
+		}
+		//a stream that delivered and then dropped is worth reconnecting to straight away
+		if (eventsThisConnection > 0) return CONNECT_ENDED;
+		std::cout << "Update stream: " << e.what() << std::endl;
+		httpFailures[HTTP_STREAM].add();
+		return CONNECT_FAILED;
+	}
+	if (!streaming && !body.empty()) {
+		//long poll answer, the next poll asks for what came after it
+		if (!pollEventId.empty()) {
+			lastEventId = pollEventId;
+		}
+		deliver(body);
+	}
+	return CONNECT_ENDED;
+}
+
+void StreamUpdateSource::deliver(const std::string& data) {
+	auto batch = std::make_shared<ScheduleBatch>();
+	batch->refresh = true;
+	batch->response = data;
+	batch->receivedAt = SDL_GetPerformanceCounter();
+	batch->ok = scanBatch(batch.get());
+	eventsThisConnection++;
+	if (!batch->ok) {
+		std::cout << "Update stream: unreadable event" << std::endl;
+		return;
+	}
+	events++;
+	finished.push(batch);
+}
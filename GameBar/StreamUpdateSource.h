@@ -0,0 +1,90 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "LockFreeQueue.h"
+#include "UpdateSource.h"
+
+//Splits a text/event-stream into events as bytes arrive, in any chunking. Lines may end in \n, \r\n or \r.
+class EventStreamParser
+{
+public:
+	typedef std::function<void(const std::string& type, const std::string& data, const std::string& id)> EventHandler;
+
+	EventStreamParser(EventHandler handler);
+
+	void feed(const char* bytes, size_t length);
+
+	//Forgets a partly received event, for a new connection.
+	void reset();
+
+	//reconnection delay the server asked for with "retry:", 0 if it didn't
+	Uint32 getRetryMs();
+
+private:
+	void processLine(const std::string& line);
+
+	EventHandler onEvent;
+	std::string line;
+	std::string type;
+	std::string data;
+	std::string id;
+	bool afterCR;
+	Uint32 retryMs;
+};
+
+//Follows a server-sent event stream of game updates on its own thread, reconnecting with backoff.
+//GET url + "from=YYYY-MM-DD&to=YYYY-MM-DD" with Accept: text/event-stream, and Last-Event-ID after a reconnect.
+//Each event's data is a schedule response holding the complete current records of the games that changed;
+//":" comment lines keep an idle connection alive. A response that isn't an event stream is taken as a long
+//poll: its body is one update and its Last-Event-ID header that update's id, sent back on the next request,
+//which is made straight away.
+class StreamUpdateSource : public UpdateSource
+{
+public:
+	StreamUpdateSource(std::string url);
+
+	//Stops the thread, abandoning an open connection.
+	~StreamUpdateSource();
+
+	void watch(int firstDay, int lastDay) override;
+	void update(Uint32 now) override;
+	bool poll(std::shared_ptr<ScheduleBatch>* batch) override;
+	bool isHealthy() override;
+	const char* getName() override;
+	void printStats() override;
+
+private:
+	//how one connection ended
+	enum ConnectResult {
+		CONNECT_FAILED,
+		CONNECT_ENDED,
+		CONNECT_INTERRUPTED
+	};
+
+	void run();
+	ConnectResult connect(const std::string& url, int generation);
+	void deliver(const std::string& data);
+
+	std::string baseUrl;
+	//followed days, written by the UI thread; a new generation drops the connection so it reopens for them
+	std::mutex daysLock;
+	int firstDay, lastDay;
+	std::atomic<int> generation;
+	//stream thread only
+	std::string lastEventId;
+	int eventsThisConnection;
+	EventStreamParser parser;
+
+	MpscQueue<std::shared_ptr<ScheduleBatch>> finished;
+	std::atomic<int> failures;
+	std::atomic<bool> stopping;
+	std::atomic<size_t> bytes;
+	std::atomic<int> events, connections;
+	//cuts the wait between connections short
+	SDL_sem* wake;
+	std::thread thread;
+};
@@ -0,0 +1,39 @@
+#include "StringArena.h"
+#include <cstring>
+#include <functional>
+
+StringRef StringArena::intern(const std::string& s) {
+	size_t hash = std::hash<std::string>()(s);
+	auto range = index.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		StringRef ref = it->second;
+		if (ref.length == s.size() && memcmp(&buffer[ref.offset], s.data(), s.size()) == 0) {
+			return ref;
+		}
+	}
+	StringRef ref;
+	ref.offset = (uint32_t)buffer.size();
+	ref.length = (uint32_t)s.size();
+	buffer.insert(buffer.end(), s.begin(), s.end());
+	buffer.push_back('\0');
+	index.emplace(hash, ref);
+	return ref;
+}
+
+const char* StringArena::c_str(StringRef ref) const {
+	if (buffer.empty()) return "";
+	return &buffer[ref.offset];
+}
+
+std::string StringArena::get(StringRef ref) const {
+	if (buffer.empty()) return std::string();
+	return std::string(&buffer[ref.offset], ref.length);
+}
+
+void StringArena::reserve(size_t bytes) {
+	buffer.reserve(bytes);
+}
+
+size_t StringArena::size() const {
+	return buffer.size();
+}
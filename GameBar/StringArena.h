@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Location of an interned string inside a StringArena.
+struct StringRef {
+	uint32_t offset = 0;
+	uint32_t length = 0;
+};
+
+//Append-only storage for cold strings. Each distinct string is stored once, null terminated, in one
+//contiguous buffer and referred to by offset, so repeated team names and dates cost nothing extra.
+class StringArena
+{
+public:
+	//Returns the reference for s, appending it if it hasn't been seen before.
+	StringRef intern(const std::string& s);
+
+	//Null terminated pointer to the string. Invalidated by the next intern().
+	const char* c_str(StringRef ref) const;
+	std::string get(StringRef ref) const;
+
+	void reserve(size_t bytes);
+	size_t size() const;
+
+private:
+	std::vector<char> buffer;
+	//hash of contents -> every ref with that hash
+	std::unordered_multimap<size_t, StringRef> index;
+};
@@ -0,0 +1,130 @@
+#include "TexturePool.h"
+#include "Metrics.h"
+#include <iostream>
+
+TexturePool::TexturePool(SDL_Renderer* renderer) {
+	ren = renderer;
+	texturesCreated = texturesReused = texturesInUse = texturesInUsePeak = 0;
+	buffersCreated = buffersInUse = buffersInUsePeak = 0;
+	bufferBytesPeak = 0;
+}
+
+TexturePool::~TexturePool() {
+	for (auto& entry : textureSizes) {
+		SDL_DestroyTexture(entry.first);
+	}
+	for (PixelBuffer* buffer : allBuffers) {
+		delete buffer;
+	}
+	texturesResident.set(0);
+	textureBytesResident.set(0);
+	decodeBufferBytes.set(0);
+}
+
+SDL_Texture* TexturePool::uploadTexture(PixelBuffer* buffer) {
+	SDL_Texture* tex = acquireTexture(buffer->w, buffer->h);
+	if (tex == nullptr) {
+		return nullptr;
+	}
+	if (SDL_UpdateTexture(tex, NULL, buffer->pixels.data(), buffer->pitch) != 0) {
+		std::cout << "SDL_UpdateTexture Error: " << SDL_GetError() << std::endl;
+		releaseTexture(tex);
+		return nullptr;
+	}
+	return tex;
+}
+
+SDL_Texture* TexturePool::acquireTexture(int w, int h) {
+	SDL_Texture* tex = nullptr;
+	std::vector<SDL_Texture*>& available = freeTextures[std::make_pair(w, h)];
+	if (!available.empty()) {
+		tex = available.back();
+		available.pop_back();
+		texturesReused++;
+	}
+	else {
+		tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, w, h);
+		if (tex == nullptr) {
+			std::cout << "SDL_CreateTexture Error: " << SDL_GetError() << std::endl;
+			return nullptr;
+		}
+		textureSizes[tex] = std::make_pair(w, h);
+		texturesCreated++;
+	}
+	texturesInUse++;
+	texturesResident.add(1);
+	textureBytesResident.add((int64_t)w * h * 4);
+	if (texturesInUse > texturesInUsePeak) {
+		texturesInUsePeak = texturesInUse;
+	}
+	return tex;
+}
+
+void TexturePool::releaseTexture(SDL_Texture* tex) {
+	if (tex == nullptr) return;
+	auto size = textureSizes.find(tex);
+	if (size == textureSizes.end()) {
+		//not ours, nothing to recycle
+		SDL_DestroyTexture(tex);
+		return;
+	}
+	freeTextures[size->second].push_back(tex);
+	texturesInUse--;
+	texturesResident.add(-1);
+	textureBytesResident.add(-(int64_t)size->second.first * size->second.second * 4);
+}
+
+PixelBuffer* TexturePool::acquireBuffer() {
+	std::lock_guard<std::mutex> guard(bufferLock);
+	PixelBuffer* buffer;
+	if (!freeBuffers.empty()) {
+		buffer = freeBuffers.back();
+		freeBuffers.pop_back();
+	}
+	else {
+		buffer = new PixelBuffer();
+		allBuffers.push_back(buffer);
+		buffersCreated++;
+	}
+	buffersInUse++;
+	if (buffersInUse > buffersInUsePeak) {
+		buffersInUsePeak = buffersInUse;
+	}
+	return buffer;
+}
+
+void TexturePool::releaseBuffer(PixelBuffer* buffer) {
+	if (buffer == nullptr) return;
+	std::lock_guard<std::mutex> guard(bufferLock);
+	if (buffer->pixels.capacity() > bufferBytesPeak) {
+		bufferBytesPeak = buffer->pixels.capacity();
+	}
+	freeBuffers.push_back(buffer);
+	buffersInUse--;
+	//buffers only grow, and only while out
+	decodeBufferBytes.add((int64_t)(buffer->pixels.capacity() - buffer->countedBytes));
+	buffer->countedBytes = buffer->pixels.capacity();
+}
+
+void TexturePool::printStats() {
+	std::cout << "Texture pool: " << texturesCreated << " created, " << texturesReused << " reused, "
+		<< texturesInUsePeak << " in use at peak" << std::endl;
+	std::cout << "Decode buffer pool: " << buffersCreated << " created, " << buffersInUsePeak << " in use at peak, "
+		<< bufferBytesPeak << " bytes largest buffer" << std::endl;
+}
+
+int TexturePool::getTexturesCreated() {
+	return texturesCreated;
+}
+
+int TexturePool::getTexturesInUsePeak() {
+	return texturesInUsePeak;
+}
+
+int TexturePool::getBuffersCreated() {
+	return buffersCreated;
+}
+
+int TexturePool::getBuffersInUsePeak() {
+	return buffersInUsePeak;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+//CPU side decode target. Rows are packed 32-bit RGBA, pitch == w * 4.
+struct PixelBuffer {
+	std::vector<Uint8> pixels;
+	int w = 0;
+	int h = 0;
+	int pitch = 0;
+	size_t countedBytes = 0; //capacity as of the last release, for the decode buffer metric
+};
+
+//Recycles same-size streaming textures and decode buffers so scrolling doesn't create/destroy them every step.
+//Texture functions belong to the render thread. Buffer functions are thread safe, decode jobs run on workers.
+class TexturePool
+{
+public:
+	TexturePool(SDL_Renderer* renderer);
+
+	//Destroys every texture and buffer owned by the pool, in use or not.
+	~TexturePool();
+
+	//Uploads an already decoded buffer to a pooled texture. Returns nullptr on failure.
+	SDL_Texture* uploadTexture(PixelBuffer* buffer);
+
+	//Returns a streaming RGBA texture of the given size, reusing a released one when possible.
+	SDL_Texture* acquireTexture(int w, int h);
+
+	//Hands a texture back for reuse. Textures not created by this pool are destroyed.
+	void releaseTexture(SDL_Texture* tex);
+
+	//Returns an empty decode buffer, reusing a released one when possible.
+	PixelBuffer* acquireBuffer();
+
+	//Hands a decode buffer back for reuse. Its memory is kept.
+	void releaseBuffer(PixelBuffer* buffer);
+
+	//Prints creation counts and high-water marks to stdout.
+	void printStats();
+
+	int getTexturesCreated();
+	int getTexturesInUsePeak();
+	int getBuffersCreated();
+	int getBuffersInUsePeak();
+
+private:
+	SDL_Renderer* ren;
+	//free textures keyed by size
+	std::map<std::pair<int, int>, std::vector<SDL_Texture*>> freeTextures;
+	std::map<SDL_Texture*, std::pair<int, int>> textureSizes;
+	std::mutex bufferLock;
+	std::vector<PixelBuffer*> freeBuffers;
+	std::vector<PixelBuffer*> allBuffers;
+
+	int texturesCreated, texturesReused, texturesInUse, texturesInUsePeak;
+	int buffersCreated, buffersInUse, buffersInUsePeak;
+	size_t bufferBytesPeak;
+};
@@ -0,0 +1,145 @@
+#include "Trace.h"
+#include "Constants.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+struct TraceRecord {
+	Uint64 start;
+	Uint64 end;
+	Uint64 flow;
+	const char* category;
+	const char* name;
+	TraceFlowStep step;
+};
+
+//One thread's records; only that thread writes, writeTrace() reads behind it.
+struct TraceRing {
+	//records written so far, the last TRACE_RING_EVENTS of them still in records
+	std::atomic<Uint64> head{ 0 };
+	TraceRecord records[TRACE_RING_EVENTS];
+	int tid = 0;
+	const char* name = nullptr;
+};
+
+static std::atomic<bool> tracing(false);
+static int sampleEvery = 1;
+static std::atomic<Uint64> flowCount(0);
+static Uint64 traceStart = 0;
+//rings outlive their threads so what a finished thread did can still be written out
+static std::mutex ringsLock;
+static std::vector<TraceRing*> rings;
+static thread_local TraceRing* threadRing = nullptr;
+static thread_local const char* threadName = nullptr;
+static thread_local Uint64 threadFlow = 0;
+
+static TraceRing* ringForThread() {
+	if (!threadRing) {
+		threadRing = new TraceRing();
+		threadRing->name = threadName;
+		std::lock_guard<std::mutex> guard(ringsLock);
+		threadRing->tid = (int)rings.size() + 1;
+		rings.push_back(threadRing);
+	}
+	return threadRing;
+}
+
+void startTracing(int sampleRate) {
+	sampleEvery = sampleRate > 0 ? sampleRate : 1;
+	traceStart = SDL_GetPerformanceCounter();
+	tracing = true;
+}
+
+bool isTracing() {
+	return tracing.load(std::memory_order_relaxed);
+}
+
+void setTraceThreadName(const char* name) {
+	threadName = name;
+	if (threadRing) {
+		threadRing->name = name;
+	}
+}
+
+Uint64 newTraceFlow() {
+	if (!isTracing()) return 0;
+	Uint64 request = flowCount.fetch_add(1, std::memory_order_relaxed);
+	return request % sampleEvery == 0 ? request + 1 : 0;
+}
+
+void setTraceFlow(Uint64 flow) {
+	threadFlow = flow;
+}
+
+Uint64 getTraceFlow() {
+	return threadFlow;
+}
+
+void traceSpan(const char* category, const char* name, Uint64 start, Uint64 end, Uint64 flow, TraceFlowStep step) {
+	if (!isTracing()) return;
+	TraceRing* ring = ringForThread();
+	Uint64 index = ring->head.load(std::memory_order_relaxed);
+	TraceRecord& record = ring->records[index % TRACE_RING_EVENTS];
+	record.start = start;
+	record.end = end;
+	record.flow = flow;
+	record.category = category;
+	record.name = name;
+	record.step = step;
+	ring->head.store(index + 1, std::memory_order_release);
+}
+
+bool writeTrace(const std::string& path) {
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file) {
+		std::cout << "Error opening file " << path << "!" << std::endl;
+		return false;
+	}
+	double ticksPerUs = SDL_GetPerformanceFrequency() / 1e6;
+	std::vector<TraceRing*> threads;
+	{
+		std::lock_guard<std::mutex> guard(ringsLock);
+		threads = rings;
+	}
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GameBar\"}}");
+	std::vector<TraceRecord> records;
+	int written = 0;
+	for (TraceRing* ring : threads) {
+		if (ring->name) {
+			fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", ring->tid, ring->name);
+		}
+		//copy out what the ring holds, then drop whatever the thread overwrote meanwhile
+		Uint64 head = ring->head.load(std::memory_order_acquire);
+		Uint64 first = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+		records.clear();
+		for (Uint64 i = first; i < head; i++) {
+			records.push_back(ring->records[i % TRACE_RING_EVENTS]);
+		}
+		Uint64 after = ring->head.load(std::memory_order_acquire);
+		//the slot being written when we looked again may be torn too
+		Uint64 intact = after + 1 > TRACE_RING_EVENTS ? after + 1 - TRACE_RING_EVENTS : 0;
+		for (Uint64 i = std::max(first, intact); i < head; i++) {
+			const TraceRecord& record = records[i - first];
+			if (record.start < traceStart) continue;
+			double ts = (record.start - traceStart) / ticksPerUs;
+			//a moment gets a sliver of width so flow arrows have a slice to attach to
+			double dur = std::max((record.end - record.start) / ticksPerUs, 1.0);
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+				record.name, record.category, ts, dur, ring->tid);
+			if (record.flow != 0) {
+				const char* phase = record.step == TRACE_FLOW_START ? "s" : record.step == TRACE_FLOW_END ? "f" : "t";
+				fprintf(file, ",\n{\"name\":\"image\",\"cat\":\"flow\",\"ph\":\"%s\",\"bp\":\"e\",\"id\":%llu,\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+					phase, (unsigned long long)record.flow, ts, ring->tid);
+			}
+			written++;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	bool ok = fclose(file) == 0;
+	std::cout << "Trace: " << written << " spans from " << threads.size() << " threads written to " << path << std::endl;
+	return ok;
+}
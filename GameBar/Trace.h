@@ -0,0 +1,37 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <string>
+
+//Timeline tracing, written out as Chrome trace-event JSON for chrome://tracing or Perfetto. Each thread records
+//into its own ring of the last TRACE_RING_EVENTS spans, so recording takes no lock and the newest events win.
+//Every PhaseTimer span is recorded while tracing is on. An image request can also be followed as a flow: queued,
+//dns, connect, first byte, transfer, decode, upload and first presented, linked by arrows across threads. Only one
+//in sampleRate image requests is followed, which keeps tracing cheap enough to leave on.
+//Times are SDL_GetPerformanceCounter() ticks.
+
+enum TraceFlowStep {
+	TRACE_FLOW_START,
+	TRACE_FLOW_STEP,
+	TRACE_FLOW_END
+};
+
+//Turns tracing on, following one in sampleRate image requests. Off, every call here returns at once.
+void startTracing(int sampleRate);
+bool isTracing();
+
+//Names the calling thread in the trace.
+void setTraceThreadName(const char* name);
+
+//Returns the flow id for a new image request, or 0 if it isn't one of the sampled ones.
+Uint64 newTraceFlow();
+//Flow the calling thread is working for, so code that doesn't know which request it serves (a download) can
+//attach its spans to it. 0 for none.
+void setTraceFlow(Uint64 flow);
+Uint64 getTraceFlow();
+
+//Records a span from start to end (equal for a moment in time). With a flow, it is also linked into that flow.
+//category and name must be string literals, only the pointers are kept.
+void traceSpan(const char* category, const char* name, Uint64 start, Uint64 end, Uint64 flow = 0, TraceFlowStep step = TRACE_FLOW_STEP);
+
+//Writes every thread's ring to path. Safe while other threads keep recording. Returns false if path couldn't be written.
+bool writeTrace(const std::string& path);
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ScheduleParser.h"
+#include "HttpStub.h"
+
+//Standalone stand-in for a live update server, to drive StreamUpdateSource and PollingUpdateSource without
+//statsapi. Scores of one day's games change every few seconds; each change is an event.
+//  GET /events?from=...&to=...   text/event-stream of changed games, replaying after Last-Event-ID.
+//                                With longpoll=1 (or without Accept: text/event-stream) one event as plain
+//                                JSON with its id in a Last-Event-ID header, or 204 after 30 s without one.
+//  GET /schedule?...             the whole day, with an ETag; 304 when If-None-Match still matches.
+//Usage: UpdateServer [port] [event interval ms] [schedule.json to take games from] [drop stream after N events]
+
+struct LiveGame {
+	int gamePk;
+	std::string date, start, away, home, headline;
+	int awayScore = 0;
+	int homeScore = 0;
+};
+
+std::mutex stateLock;
+std::condition_variable changed;
+std::vector<LiveGame> liveGames;
+//event i has id i + 1
+std::vector<std::string> eventLog;
+int dropAfter = 0;
+
+std::string escape(const std::string& s) {
+	std::string out;
+	for (char c : s) {
+		if (c == '"' || c == '\\') out += '\\';
+		out += c;
+	}
+	return out;
+}
+
+std::string gameJson(const LiveGame& game) {
+	std::ostringstream json;
+	json << "{\"gamePk\":" << game.gamePk << ",\"officialDate\":\"" << game.date << "\",\"gameDate\":\"" << game.start << "\",\"doubleHeader\":\"N\",\"gameNumber\":1,"
+		<< "\"teams\":{\"away\":{\"score\":" << game.awayScore << ",\"team\":{\"name\":\"" << escape(game.away) << "\"}},"
+		<< "\"home\":{\"score\":" << game.homeScore << ",\"team\":{\"name\":\"" << escape(game.home) << "\"}}}";
+	if (!game.headline.empty()) {
+		json << ",\"content\":{\"editorial\":{\"recap\":{\"mlb\":{\"headline\":\"" << escape(game.headline) << "\"}}}}";
+	}
+	json << "}";
+	return json.str();
+}
+
+//Schedule response holding the given games, the shape every update carries.
+std::string scheduleJson(const std::vector<const LiveGame*>& games) {
+	std::ostringstream json;
+	json << "{\"totalGames\":" << games.size() << ",\"dates\":[{\"date\":\"" << (games.empty() ? "" : games[0]->date) << "\",\"games\":[";
+	for (size_t i = 0; i < games.size(); i++) {
+		json << (i ? "," : "") << gameJson(*games[i]);
+	}
+	json << "]}]}";
+	return json.str();
+}
+
+void loadGames(const char* path) {
+	std::ifstream file(path, std::ios::binary);
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	ScheduleRecords records;
+	if (!file || !extractSchedule(text, &records)) {
+		std::cout << "Can't read " << path << ", using made up games" << std::endl;
+	}
+	for (const GameRecord& record : records.games) {
+		LiveGame game;
+		game.gamePk = record.gamePk;
+		game.date = jsonUnescape(record.officialDate);
+		game.start = jsonUnescape(record.gameDate);
+		game.away = jsonUnescape(record.awayName);
+		game.home = jsonUnescape(record.homeName);
+		liveGames.push_back(game);
+	}
+}
+
+void makeGames() {
+	for (int i = 0; i < 15; i++) {
+		LiveGame game;
+		game.gamePk = 530000 + i;
+		game.date = "2018-06-10";
+		game.start = game.date + "T" + std::to_string(16 + i / 3) + ":05:00Z";
+		game.away = "Away Team " + std::to_string(i);
+		game.home = "Home Team " + std::to_string(i);
+		liveGames.push_back(game);
+	}
+}
+
+//Scores a run somewhere every interval; now and then a game gets its recap headline.
+void ticker(int intervalMs) {
+	std::mt19937 random(1234);
+	while (true) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+		std::lock_guard<std::mutex> guard(stateLock);
+		LiveGame& game = liveGames[random() % liveGames.size()];
+		(random() % 2 ? game.awayScore : game.homeScore)++;
+		if (random() % 8 == 0) {
+			game.headline = game.away + " and " + game.home + " trade runs, " + std::to_string(game.awayScore) + "-" + std::to_string(game.homeScore);
+		}
+		eventLog.push_back(scheduleJson({ &game }));
+		changed.notify_all();
+	}
+}
+
+void serveSchedule(Socket client, const std::string& request) {
+	std::string body, etag;
+	{
+		std::lock_guard<std::mutex> guard(stateLock);
+		std::vector<const LiveGame*> games;
+		for (const LiveGame& game : liveGames) games.push_back(&game);
+		body = scheduleJson(games);
+		etag = "\"v" + std::to_string(eventLog.size()) + "\"";
+	}
+	if (header(request, "if-none-match") == etag) {
+		sendAll(client, "HTTP/1.1 304 Not Modified\r\nETag: " + etag + "\r\nConnection: close\r\n\r\n");
+		return;
+	}
+	sendAll(client, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: " + etag + "\r\nContent-Length: " +
+		std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+}
+
+void serveEvents(Socket client, const std::string& request, bool longPoll) {
+	size_t next = (size_t)atoi(header(request, "last-event-id").c_str());
+	std::unique_lock<std::mutex> guard(stateLock);
+	if (longPoll) {
+		bool ready = changed.wait_for(guard, std::chrono::seconds(30), [next]() { return eventLog.size() > next; });
+		if (!ready) {
+			guard.unlock();
+			sendAll(client, "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n");
+			return;
+		}
+		std::string body = eventLog[next];
+		guard.unlock();
+		//the id comes back as the next request's Last-Event-ID, so each poll picks up where the last left off
+		sendAll(client, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nLast-Event-ID: " + std::to_string(next + 1) +
+			"\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+		return;
+	}
+	guard.unlock();
+	if (!sendAll(client, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\nretry: 1000\n\n")) return;
+	int sentEvents = 0;
+	while (dropAfter == 0 || sentEvents < dropAfter) {
+		guard.lock();
+		bool ready = changed.wait_for(guard, std::chrono::seconds(15), [next]() { return eventLog.size() > next; });
+		std::string out;
+		if (!ready) {
+			out = ": keepalive\n\n";
+		}
+		while (next < eventLog.size()) {
+			out += "id: " + std::to_string(next + 1) + "\nevent: games\ndata: " + eventLog[next] + "\n\n";
+			next++;
+			sentEvents++;
+		}
+		guard.unlock();
+		if (!sendAll(client, out)) return;
+	}
+	//simulated drop, the client reconnects with Last-Event-ID
+}
+
+void serve(Socket client) {
+	std::string request = readRequest(client);
+	std::string path = requestPath(request);
+	std::cout << path << std::endl;
+	if (path.compare(0, 9, "/schedule") == 0) {
+		serveSchedule(client, request);
+	}
+	else if (path.compare(0, 7, "/events") == 0) {
+		bool longPoll = path.find("longpoll=1") != std::string::npos || header(request, "accept").find("text/event-stream") == std::string::npos;
+		serveEvents(client, request, longPoll);
+	}
+	else {
+		sendAll(client, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+	}
+	closesocket(client);
+}
+
+int main(int argc, char* argv[]) {
+	int port = argc > 1 ? atoi(argv[1]) : 8080;
+	int intervalMs = argc > 2 ? atoi(argv[2]) : 3000;
+	if (argc > 3) {
+		loadGames(argv[3]);
+	}
+	if (liveGames.empty()) {
+		makeGames();
+	}
+	dropAfter = argc > 4 ? atoi(argv[4]) : 0;
+	Socket listener = listenLocal(port, 16);
+	if (listener == INVALID_SOCKET) return 1;
+	std::cout << "Serving " << liveGames.size() << " games on http://localhost:" << port << "/events? and /schedule?" << std::endl;
+	std::thread(ticker, intervalMs).detach();
+	acceptForever(listener, serve);
+}
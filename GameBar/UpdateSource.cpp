@@ -0,0 +1,45 @@
+#include "UpdateSource.h"
+#include <iostream>
+
+FallbackUpdateSource::FallbackUpdateSource(UpdateSource* primarySource, UpdateSource* fallbackSource)
+	: primary(primarySource), fallback(fallbackSource) {
+	usingFallback = false;
+	switches = 0;
+}
+
+void FallbackUpdateSource::watch(int firstDay, int lastDay) {
+	primary->watch(firstDay, lastDay);
+	fallback->watch(firstDay, lastDay);
+}
+
+void FallbackUpdateSource::update(Uint32 now) {
+	primary->update(now);
+	bool wantFallback = !primary->isHealthy();
+	if (wantFallback != usingFallback) {
+		usingFallback = wantFallback;
+		switches++;
+		std::cout << "Live updates: " << (usingFallback ? fallback : primary)->getName() << std::endl;
+	}
+	if (usingFallback) {
+		fallback->update(now);
+	}
+}
+
+bool FallbackUpdateSource::poll(std::shared_ptr<ScheduleBatch>* batch) {
+	//whatever either already fetched is still news
+	return primary->poll(batch) || fallback->poll(batch);
+}
+
+bool FallbackUpdateSource::isHealthy() {
+	return primary->isHealthy() || fallback->isHealthy();
+}
+
+const char* FallbackUpdateSource::getName() {
+	return usingFallback ? fallback->getName() : primary->getName();
+}
+
+void FallbackUpdateSource::printStats() {
+	primary->printStats();
+	fallback->printStats();
+	std::cout << "Live updates: switched source " << switches << " times" << std::endl;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <memory>
+#include "ScheduleLoader.h"
+
+//Where live score and headline updates come from. A source delivers ScheduleBatches with refresh set, each
+//holding the complete current records of games that may have changed, ready for GameStore::patchGame().
+//Every function is called from the UI thread; what a source does in the background is up to it.
+class UpdateSource
+{
+public:
+	virtual ~UpdateSource() {}
+
+	//Follows the days firstDay..lastDay (see DateIndex.h) from now on. Called every frame, usually unchanged.
+	virtual void watch(int firstDay, int lastDay) = 0;
+
+	//Called every frame. Sources that poll decide here whether it's time to.
+	virtual void update(Uint32 now) = 0;
+
+	//Takes the next batch of updated games, returns false if there is none.
+	virtual bool poll(std::shared_ptr<ScheduleBatch>* batch) = 0;
+
+	//Whether the source is delivering. A stream that keeps failing to connect isn't.
+	virtual bool isHealthy() = 0;
+
+	virtual const char* getName() = 0;
+
+	//Prints what the source fetched to stdout.
+	virtual void printStats() = 0;
+};
+
+//Uses primary while it is healthy and fallback while it isn't, typically a push stream backed by polling.
+//Batches from either are delivered; a fallback catching up after a switch only patches what changed.
+class FallbackUpdateSource : public UpdateSource
+{
+public:
+	//Takes ownership of both.
+	FallbackUpdateSource(UpdateSource* primary, UpdateSource* fallback);
+
+	void watch(int firstDay, int lastDay) override;
+	void update(Uint32 now) override;
+	bool poll(std::shared_ptr<ScheduleBatch>* batch) override;
+	bool isHealthy() override;
+	const char* getName() override;
+	void printStats() override;
+
+private:
+	std::unique_ptr<UpdateSource> primary;
+	std::unique_ptr<UpdateSource> fallback;
+	bool usingFallback;
+	int switches;
+};
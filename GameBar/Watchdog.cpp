@@ -0,0 +1,221 @@
+#include "Watchdog.h"
+#include "Constants.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+//What the watched thread was doing when a frame overran.
+struct StallReport {
+	Uint32 sequence;
+	Uint32 frame;
+	Uint32 start;
+	Uint32 ms;
+	bool finished; //ms is the whole stall, not just so far
+	Phase phase;
+	int gameId;
+	std::string url;
+	char when[32];
+};
+
+//set by the watched thread, read by the watchdog
+static std::atomic<bool> inFrame(false);
+static std::atomic<Uint32> frameStart(0), frameNumber(0);
+//the frame being reported as stalled, and how long it took once it completes
+static std::atomic<Uint32> stalledFrame(0), stalledMs(0);
+static std::atomic<int> watchedPhase(PHASE_COUNT);
+static std::atomic<int> watchedGame(-1);
+static std::mutex urlLock;
+static std::string watchedUrl;
+static thread_local bool onWatchedThread = false;
+
+static Uint32 deadline = 0;
+static std::string logFile;
+static FILE* ringLog = nullptr;
+static Uint32 nextSequence = 0;
+static SDL_sem* wake = nullptr;
+static std::thread watcher;
+//by phase, the last for stalls outside any; only the watchdog thread writes them
+static int stallCounts[PHASE_COUNT + 1];
+
+static const char* phaseLabel(int phase) {
+	return phase < PHASE_COUNT ? phaseName((Phase)phase) : "no phase";
+}
+
+//Opens the ring log, carrying on after the newest line already in it.
+static void openLog() {
+	ringLog = fopen(logFile.c_str(), "r+b");
+	if (ringLog) {
+		char line[STALL_LOG_LINE];
+		while (fread(line, 1, STALL_LOG_LINE, ringLog) == STALL_LOG_LINE) {
+			Uint32 sequence = (Uint32)strtoul(line, nullptr, 10);
+			nextSequence = std::max(nextSequence, sequence + 1);
+		}
+		return;
+	}
+	ringLog = fopen(logFile.c_str(), "w+b");
+	if (!ringLog) {
+		std::cout << "Error opening file " << logFile << "!" << std::endl;
+	}
+}
+
+//Writes report over its slot of the ring, padded to STALL_LOG_LINE.
+static void writeReport(const StallReport& report) {
+	char line[STALL_LOG_LINE];
+	int length = snprintf(line, sizeof(line), "%010u %s frame %u stalled %s%u ms in %s", report.sequence, report.when,
+		report.frame, report.finished ? "" : ">", report.ms, phaseLabel(report.phase));
+	if (report.gameId >= 0 && length < STALL_LOG_LINE) {
+		length += snprintf(line + length, sizeof(line) - length, ", game %d", report.gameId);
+	}
+	if (!report.url.empty() && length < STALL_LOG_LINE) {
+		length += snprintf(line + length, sizeof(line) - length, ", %s", report.url.c_str());
+	}
+	//cut to fit, then pad
+	length = std::min(length, STALL_LOG_LINE - 1);
+	std::fill(line + length, line + STALL_LOG_LINE - 1, ' ');
+	line[STALL_LOG_LINE - 1] = '\n';
+	if (!ringLog) return;
+	fseek(ringLog, (long)(report.sequence % STALL_LOG_ENTRIES) * STALL_LOG_LINE, SEEK_SET);
+	fwrite(line, 1, STALL_LOG_LINE, ringLog);
+	fflush(ringLog);
+}
+
+static void watch() {
+	setTraceThreadName("watchdog");
+	Uint32 interval = std::max<Uint32>(deadline / 4, 10);
+	Uint32 reportedFrame = 0;
+	bool open = false;
+	StallReport report;
+	//posted to stop
+	while (SDL_SemWaitTimeout(wake, interval) != 0) {
+		Uint32 frame = frameNumber.load();
+		bool busy = inFrame.load();
+		if (open && (frame != report.frame || !busy)) {
+			//0 if the frame completed just as it was reported, so it is only known to be past the deadline
+			report.ms = std::max(stalledMs.load(), report.ms);
+			report.finished = true;
+			writeReport(report);
+			std::cout << "Stall over: frame " << report.frame << " took " << report.ms << " ms" << std::endl;
+			open = false;
+		}
+		Uint32 start = frameStart.load();
+		Uint32 now = SDL_GetTicks();
+		if (!open && busy && frame != reportedFrame && now - start > deadline) {
+			stalledMs.store(0);
+			stalledFrame.store(frame);
+			report.sequence = nextSequence++;
+			report.frame = frame;
+			report.start = start;
+			report.ms = now - start;
+			report.finished = false;
+			report.phase = (Phase)watchedPhase.load();
+			report.gameId = watchedGame.load();
+			{
+				std::lock_guard<std::mutex> guard(urlLock);
+				report.url = watchedUrl;
+			}
+			time_t wall = time(nullptr);
+			strftime(report.when, sizeof(report.when), "%Y-%m-%d %H:%M:%S", localtime(&wall));
+			stallCounts[report.phase]++;
+			stalls[report.phase].add();
+			writeReport(report);
+			std::cout << "Stall: frame " << frame << " stuck " << report.ms << " ms in " << phaseLabel(report.phase);
+			if (report.gameId >= 0) {
+				std::cout << ", game " << report.gameId;
+			}
+			if (!report.url.empty()) {
+				std::cout << ", " << report.url;
+			}
+			std::cout << std::endl;
+			reportedFrame = frame;
+			open = true;
+		}
+	}
+	//stopped mid stall
+	if (open) {
+		report.ms = SDL_GetTicks() - report.start;
+		writeReport(report);
+	}
+}
+
+void startWatchdog(Uint32 deadlineMs, const std::string& logPath) {
+	onWatchedThread = true;
+	deadline = deadlineMs;
+	if (deadline == 0) return;
+	logFile = logPath;
+	openLog();
+	wake = SDL_CreateSemaphore(0);
+	watcher = std::thread(watch);
+}
+
+void stopWatchdog() {
+	if (!wake) return;
+	SDL_SemPost(wake);
+	watcher.join();
+	SDL_DestroySemaphore(wake);
+	wake = nullptr;
+	if (ringLog) {
+		fclose(ringLog);
+		ringLog = nullptr;
+	}
+	int total = 0;
+	for (int count : stallCounts) {
+		total += count;
+	}
+	std::cout << "Stalls over " << deadline << " ms: " << total;
+	for (int phase = 0; phase <= PHASE_COUNT; phase++) {
+		if (stallCounts[phase] > 0) {
+			std::cout << ", " << stallCounts[phase] << " in " << phaseLabel(phase);
+		}
+	}
+	std::cout << std::endl;
+}
+
+void beginWatchedFrame() {
+	frameStart.store(SDL_GetTicks());
+	frameNumber.fetch_add(1);
+	//work between the timed phases is the frame's own
+	watchedPhase.store(PHASE_FRAME);
+	inFrame.store(true);
+}
+
+void endWatchedFrame() {
+	if (stalledFrame.load() == frameNumber.load()) {
+		stalledMs.store(SDL_GetTicks() - frameStart.load());
+	}
+	inFrame.store(false);
+	watchedPhase.store(PHASE_COUNT);
+}
+
+Phase enterWatchedPhase(Phase phase) {
+	if (!onWatchedThread) return PHASE_COUNT;
+	return (Phase)watchedPhase.exchange(phase, std::memory_order_relaxed);
+}
+
+void leaveWatchedPhase(Phase outer) {
+	if (!onWatchedThread) return;
+	watchedPhase.store(outer, std::memory_order_relaxed);
+}
+
+void setWatchedGame(int gameId) {
+	watchedGame.store(gameId, std::memory_order_relaxed);
+}
+
+WatchedUrl::WatchedUrl(const std::string& url) {
+	watched = onWatchedThread;
+	if (!watched) return;
+	std::lock_guard<std::mutex> guard(urlLock);
+	watchedUrl = url;
+}
+
+WatchedUrl::~WatchedUrl() {
+	if (!watched) return;
+	std::lock_guard<std::mutex> guard(urlLock);
+	watchedUrl.clear();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "PhaseTimer.h"
+#include <SDL2/SDL.h>
+#include <string>
+
+//Watches the UI thread from a thread of its own and reports any frame that takes longer than a deadline to
+//complete, while it is still stuck: the phase it is in (PhaseTimer.h), the url it is fetching and the game it
+//is drawing, where known. Stalls are counted by phase (Metrics.h) and kept in a ring log on disk of
+//STALL_LOG_ENTRIES fixed-width lines, each rewritten with the stall's full length once the frame completes.
+//Lines start with a zero-padded sequence number, so sorting the file puts them in order.
+
+//Starts watching the calling thread, which then marks its frames with beginWatchedFrame()/endWatchedFrame().
+//A deadline of 0 leaves the watchdog off.
+void startWatchdog(Uint32 deadlineMs, const std::string& logPath);
+//Stops the watchdog thread and prints the stalls counted.
+void stopWatchdog();
+
+//The watched thread starts working on a frame; the time between frames (the frame delay) isn't watched.
+void beginWatchedFrame();
+void endWatchedFrame();
+
+//The calling thread enters phase; returns the phase to leave back to. Only the watched thread is tracked, anywhere
+//else this does nothing. PhaseTimer calls these.
+Phase enterWatchedPhase(Phase phase);
+void leaveWatchedPhase(Phase outer);
+
+//The game the watched thread is working on, -1 for none.
+void setWatchedGame(int gameId);
+
+//Names the url the scope it lives in fetches, when on the watched thread.
+class WatchedUrl
+{
+public:
+	explicit WatchedUrl(const std::string& url);
+	~WatchedUrl();
+	WatchedUrl(const WatchedUrl&) = delete;
+	WatchedUrl& operator=(const WatchedUrl&) = delete;
+
+private:
+	bool watched;
+};